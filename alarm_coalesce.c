@@ -0,0 +1,156 @@
+/***************************************************************************//**
+ * @file
+ * @brief alarm_coalesce.c
+ * A window opens with the first alarm of a source and is not extended by
+ * repeats, so a chattering sensor costs one immediate report and one summary
+ * per window. A single shot timer is armed for the earliest window end.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "alarm_coalesce.h"
+
+typedef struct {
+	bool used;
+	alarm_summary_t s;
+} alarm_slot_t;
+
+static alarm_slot_t slots[ALARM_COALESCE_SOURCES];
+static alarm_coalesce_stats_t stats;
+static alarm_summary_fn summary_fn;
+static bool timer_armed;
+
+void alarm_coalesce_init(alarm_summary_fn summary) {
+	memset(slots, 0, sizeof(slots));
+	memset(&stats, 0, sizeof(stats));
+	stats.window_ms = ALARM_COALESCE_WINDOW_MS_DEFAULT;
+	summary_fn = summary;
+	timer_armed = false;
+	app_timer_register(TIMER_ID_ALARM_COALESCE, alarm_coalesce_on_timer);
+}
+
+void alarm_coalesce_set_window(uint32 window_ms) {
+	if (window_ms > ALARM_COALESCE_WINDOW_MS_MAX) {
+		window_ms = ALARM_COALESCE_WINDOW_MS_MAX;
+	}
+	stats.window_ms = window_ms;
+}
+
+/* Arm the timer for the window closing first, stop it if none is open */
+static void alarm_arm(uint32 now) {
+	uint32 next = 0xffffffff;
+	uint8 i;
+
+	for (i = 0; i < ALARM_COALESCE_SOURCES; i++) {
+		uint32 left;
+
+		if (!slots[i].used) {
+			continue;
+		}
+		left = stats.window_ms - (now - slots[i].s.first_ms);
+		if ((int32) left < 0) {
+			left = 0;
+		}
+		if (left < next) {
+			next = left;
+		}
+	}
+	if (next == 0xffffffff) {
+		if (timer_armed) {
+			app_timer_set(0, TIMER_ID_ALARM_COALESCE, 1);
+			timer_armed = false;
+		}
+		return;
+	}
+	//A zero time would stop the timer, the soft timer runs on 1 tick at least
+	app_timer_set(
+			(next * APP_TIME_TICKS_PER_SEC) / 1000 + 1,
+			TIMER_ID_ALARM_COALESCE, 1);
+	timer_armed = true;
+}
+
+static void alarm_close(alarm_slot_t *slot) {
+	slot->used = false;
+	if (slot->s.repeats && summary_fn != NULL) {
+		summary_fn(&slot->s);
+		stats.summaries++;
+	}
+}
+
+static void alarm_open(alarm_slot_t *slot, uint16 source, uint16 message,
+		uint32 now) {
+	slot->used = true;
+	slot->s.source = source;
+	slot->s.message = message;
+	slot->s.repeats = 0;
+	slot->s.first_ms = now;
+	slot->s.last_ms = now;
+	stats.immediate++;
+	if (!timer_armed) {
+		alarm_arm(now);
+	}
+}
+
+bool alarm_coalesce_note(uint16 source, uint16 message) {
+	uint32 now = app_time_ms();
+	alarm_slot_t *free_slot = NULL;
+	uint8 i;
+
+	if (stats.window_ms == 0) {
+		stats.immediate++;
+		return true;
+	}
+	for (i = 0; i < ALARM_COALESCE_SOURCES; i++) {
+		alarm_slot_t *slot = &slots[i];
+
+		if (!slot->used) {
+			if (free_slot == NULL) {
+				free_slot = slot;
+			}
+			continue;
+		}
+		if (slot->s.source != source) {
+			continue;
+		}
+		if (now - slot->s.first_ms >= stats.window_ms) {
+			//The window is over but its timer has not run yet
+			alarm_close(slot);
+			alarm_open(slot, source, message, now);
+			return true;
+		}
+		slot->s.message = message;
+		slot->s.last_ms = now;
+		if (slot->s.repeats != 0xffff) {
+			slot->s.repeats++;
+		}
+		stats.merged++;
+		return false;
+	}
+	if (free_slot == NULL) {
+		stats.table_full++;
+		return true;
+	}
+	alarm_open(free_slot, source, message, now);
+	return true;
+}
+
+void alarm_coalesce_on_timer(void) {
+	uint32 now = app_time_ms();
+	uint8 i;
+
+	timer_armed = false;
+	for (i = 0; i < ALARM_COALESCE_SOURCES; i++) {
+		if (slots[i].used && now - slots[i].s.first_ms >= stats.window_ms) {
+			alarm_close(&slots[i]);
+		}
+	}
+	alarm_arm(now);
+}
+
+void alarm_coalesce_get_stats(alarm_coalesce_stats_t *out) {
+	*out = stats;
+}
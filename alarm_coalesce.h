@@ -0,0 +1,52 @@
+/***************************************************************************//**
+ * @file
+ * @brief alarm_coalesce.h
+ * Per source coalescing of alarm reports: the first alarm of a source goes
+ * out at once, repeats within the window become one summary.
+ ******************************************************************************/
+
+#ifndef ALARM_COALESCE_H
+#define ALARM_COALESCE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Sources debounced at a time, alarms of further sources are never held */
+#define ALARM_COALESCE_SOURCES		8
+#define ALARM_COALESCE_WINDOW_MS_DEFAULT	5000
+#define ALARM_COALESCE_WINDOW_MS_MAX	60000
+
+/* Level record following the last alarm record of a source in a summary:
+ * bits 8..15 hold the repeats, saturated at 255 */
+#define ALARM_SUMMARY_ADDRESS		0x7c
+
+#define TIMER_ID_ALARM_COALESCE		90
+
+typedef struct {
+	uint16 source;
+	uint16 message;		/* last alarm record */
+	uint16 repeats;		/* alarms after the first, within the window */
+	uint32 first_ms;	/* first and last alarm, app_time_ms() */
+	uint32 last_ms;
+} alarm_summary_t;
+
+typedef struct {
+	uint32 immediate;	/* first alarms sent at once */
+	uint32 merged;		/* repeats folded into summaries */
+	uint32 summaries;
+	uint32 table_full;	/* alarms sent at once for lack of a slot */
+	uint32 window_ms;
+} alarm_coalesce_stats_t;
+
+/* Sends the summary of a window that saw repeats */
+typedef void (*alarm_summary_fn)(const alarm_summary_t *summary);
+
+void alarm_coalesce_init(alarm_summary_fn summary);
+void alarm_coalesce_set_window(uint32 window_ms);
+/* True if the alarm is to be sent now, false if it was merged */
+bool alarm_coalesce_note(uint16 source, uint16 message);
+/* TIMER_ID_ALARM_COALESCE handler */
+void alarm_coalesce_on_timer(void);
+void alarm_coalesce_get_stats(alarm_coalesce_stats_t *stats);
+
+#endif /* ALARM_COALESCE_H */
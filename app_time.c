@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @file
+ * @brief app_time.c
+ * Read from the RTCC that init_mcu starts at boot and that keeps counting in
+ * EM2, instead of a gecko_cmd_hardware_get_time() round trip.
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_rtcc.h"
+
+#include "app_time.h"
+
+static uint32 ticks_high;
+static uint32 ticks_last;
+
+uint64_t app_time_ticks(void) {
+	uint64_t ticks;
+	uint32 now;
+	CORE_DECLARE_IRQ_STATE;
+
+	CORE_ENTER_ATOMIC();
+	now = RTCC_CounterGet();
+	if (now < ticks_last) {
+		ticks_high++;
+	}
+	ticks_last = now;
+	ticks = ((uint64_t) ticks_high << 32) | now;
+	CORE_EXIT_ATOMIC();
+	return ticks;
+}
+
+uint32 app_time_ms(void) {
+	return (uint32) (app_time_ticks() * 1000 / APP_TIME_TICKS_PER_SEC);
+}
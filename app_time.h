@@ -0,0 +1,22 @@
+/***************************************************************************//**
+ * @file
+ * @brief app_time.h
+ * Millisecond time base shared by the application modules.
+ ******************************************************************************/
+
+#ifndef APP_TIME_H
+#define APP_TIME_H
+
+#include <stdint.h>
+#include "bg_types.h"
+
+/* Stack sleep timer ticks per second, also the RTCC rate */
+#define APP_TIME_TICKS_PER_SEC	32768
+
+/* RTCC ticks since boot, monotonic. The 32 bit counter wraps every 36 hours
+ * and is extended on read: any app_time call within that period keeps it. */
+uint64_t app_time_ticks(void);
+/* Milliseconds since boot, wraps after ~49 days: compare with subtraction */
+uint32 app_time_ms(void);
+
+#endif /* APP_TIME_H */
@@ -0,0 +1,255 @@
+/***************************************************************************//**
+ * @file
+ * @brief app_timer.c
+ * Only the earliest precise deadline and the earliest lazy deadline are
+ * armed in the stack. Whichever fires, every logical timer already due is
+ * handled in the same wakeup; the lazy soft timer gets the tightest slack of
+ * the lazy timers so none of them is late by more than it allows.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+
+typedef struct {
+	bool used;
+	bool lazy;
+	uint8 id;
+	uint8 single_shot;
+	uint32 period;
+	uint32 slack;
+	uint64_t deadline;	/* app_time_ticks() */
+} app_timer_t;
+
+static app_timer_t timers[APP_TIMER_MAX];
+static app_timer_stats_t stats;
+static bool dispatching;
+/* Sorted by handle */
+static app_timer_handler_info_t handlers[APP_TIMER_MAX];
+static uint8 num_handlers;
+
+static void app_timer_on_event(struct gecko_cmd_packet *evt);
+
+void app_timer_init(void) {
+	memset(timers, 0, sizeof(timers));
+	memset(&stats, 0, sizeof(stats));
+	memset(handlers, 0, sizeof(handlers));
+	num_handlers = 0;
+	dispatching = false;
+	event_dispatch_register(gecko_evt_hardware_soft_timer_id,
+			app_timer_on_event);
+}
+
+static uint8 handler_lower_bound(uint8 id) {
+	uint8 lo = 0;
+	uint8 hi = num_handlers;
+
+	while (lo < hi) {
+		uint8 mid = (lo + hi) / 2;
+
+		if (handlers[mid].id < id) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+bool app_timer_register(uint8 id, app_timer_fn handler) {
+	uint8 pos = handler_lower_bound(id);
+
+	if (pos < num_handlers && handlers[pos].id == id) {
+		handlers[pos].handler = handler;
+		return true;
+	}
+	if (num_handlers >= APP_TIMER_MAX) {
+		return false;
+	}
+	memmove(&handlers[pos + 1], &handlers[pos],
+			(num_handlers - pos) * sizeof(handlers[0]));
+	memset(&handlers[pos], 0, sizeof(handlers[0]));
+	handlers[pos].id = id;
+	handlers[pos].handler = handler;
+	num_handlers++;
+	return true;
+}
+
+static app_timer_t *timer_find(uint8 id) {
+	uint8 i;
+
+	for (i = 0; i < APP_TIMER_MAX; i++) {
+		if (timers[i].used && timers[i].id == id) {
+			return &timers[i];
+		}
+	}
+	return NULL;
+}
+
+static uint32 ticks_until(uint64_t deadline, uint64_t now) {
+	if (deadline <= now) {
+		return 1;
+	}
+	return deadline - now > 0x7fffffff ? 0x7fffffff : deadline - now;
+}
+
+static void timer_rearm(void) {
+	uint64_t now = app_time_ticks();
+	app_timer_t *precise = NULL;
+	app_timer_t *lazy = NULL;
+	uint64_t latest = 0;
+	uint8 i;
+
+	stats.active = 0;
+	stats.lazy = 0;
+	for (i = 0; i < APP_TIMER_MAX; i++) {
+		app_timer_t *t = &timers[i];
+
+		if (!t->used) {
+			continue;
+		}
+		stats.active++;
+		if (!t->lazy) {
+			if (precise == NULL || t->deadline < precise->deadline) {
+				precise = t;
+			}
+			continue;
+		}
+		stats.lazy++;
+		if (lazy == NULL || t->deadline < lazy->deadline) {
+			lazy = t;
+		}
+		//The earliest of the latest expiries the lazy timers tolerate
+		if (stats.lazy == 1 || t->deadline + t->slack < latest) {
+			latest = t->deadline + t->slack;
+		}
+	}
+
+	gecko_cmd_hardware_set_soft_timer(
+			precise ? ticks_until(precise->deadline, now) : 0, TIMER_ID_APP_TIMER,
+			1);
+	if (lazy) {
+		uint32 time = ticks_until(lazy->deadline, now);
+		uint32 slack = ticks_until(latest, now);
+
+		gecko_cmd_hardware_set_lazy_soft_timer(time,
+				slack > time ? slack - time : 0, TIMER_ID_APP_TIMER_LAZY, 1);
+	} else {
+		gecko_cmd_hardware_set_soft_timer(0, TIMER_ID_APP_TIMER_LAZY, 1);
+	}
+}
+
+static void timer_set(uint32 time, uint32 slack, bool lazy, uint8 id,
+		uint8 single_shot) {
+	app_timer_t *t = timer_find(id);
+	uint8 i;
+
+	for (i = 0; t == NULL && time != 0 && i < APP_TIMER_MAX; i++) {
+		if (!timers[i].used) {
+			t = &timers[i];
+		}
+	}
+	if (t == NULL) {
+		return;
+	}
+	if (time == 0) {
+		t->used = false;
+	} else {
+		t->used = true;
+		t->lazy = lazy;
+		t->id = id;
+		t->single_shot = single_shot;
+		t->period = time;
+		t->slack = slack;
+		t->deadline = app_time_ticks() + time;
+	}
+	//Handlers run from app_timer_take_expired(), which rearms at the end
+	if (!dispatching) {
+		timer_rearm();
+	}
+}
+
+void app_timer_set(uint32 time, uint8 id, uint8 single_shot) {
+	timer_set(time, 0, false, id, single_shot);
+}
+
+void app_timer_set_lazy(uint32 time, uint32 slack, uint8 id, uint8 single_shot) {
+	timer_set(time, slack, true, id, single_shot);
+}
+
+static uint8 app_timer_take_expired(void) {
+	uint64_t now = app_time_ticks();
+	app_timer_t *due = NULL;
+	uint8 i;
+
+	if (!dispatching) {
+		dispatching = true;
+		stats.wakeups++;
+	}
+	for (i = 0; i < APP_TIMER_MAX; i++) {
+		app_timer_t *t = &timers[i];
+
+		if (t->used && t->deadline <= now
+				&& (due == NULL || t->deadline < due->deadline)) {
+			due = t;
+		}
+	}
+	if (due == NULL) {
+		dispatching = false;
+		timer_rearm();
+		return APP_TIMER_NONE;
+	}
+	stats.expiries++;
+	if (now - due->deadline > stats.late_ticks) {
+		stats.late_ticks = now - due->deadline;
+	}
+	if (due->single_shot) {
+		due->used = false;
+	} else {
+		due->deadline += due->period;
+		//A long stall expires a periodic timer once, not once per period
+		if (due->deadline <= now) {
+			due->deadline = now + due->period;
+		}
+	}
+	return due->id;
+}
+
+static void app_timer_on_event(struct gecko_cmd_packet *evt) {
+	uint8 handle = evt->data.evt_hardware_soft_timer.handle;
+	uint8 id;
+
+	if (handle != TIMER_ID_APP_TIMER && handle != TIMER_ID_APP_TIMER_LAZY) {
+		return;
+	}
+	while ((id = app_timer_take_expired()) != APP_TIMER_NONE) {
+		uint8 pos = handler_lower_bound(id);
+
+		if (pos < num_handlers && handlers[pos].id == id) {
+			DISPATCH_TIMED(&handlers[pos].cost, handlers[pos].handler());
+		}
+	}
+}
+
+void app_timer_get_stats(app_timer_stats_t *out) {
+	*out = stats;
+}
+
+bool app_timer_get_handler(uint8 index, app_timer_handler_info_t *info) {
+	if (index >= num_handlers) {
+		return false;
+	}
+	*info = handlers[index];
+	return true;
+}
+
+void app_timer_clear_costs(void) {
+	uint8 i;
+
+	for (i = 0; i < num_handlers; i++) {
+		memset(&handlers[i].cost, 0, sizeof(handlers[i].cost));
+	}
+}
@@ -0,0 +1,58 @@
+/***************************************************************************//**
+ * @file
+ * @brief app_timer.h
+ * Logical timers multiplexed onto two stack soft timers, one precise and one
+ * lazy. The calls mirror gecko_cmd_hardware_set_soft_timer(): the TIMER_ID_*
+ * handles stay, time 0 stops a timer. Expiries go to the handler registered
+ * for the handle.
+ ******************************************************************************/
+
+#ifndef APP_TIMER_H
+#define APP_TIMER_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#include "event_dispatch.h"
+
+#define APP_TIMER_MAX				24
+#define APP_TIMER_NONE				0xff
+
+/* Stack soft timers of the multiplexer itself */
+#define TIMER_ID_APP_TIMER			92
+#define TIMER_ID_APP_TIMER_LAZY		93
+
+/* Slack of periodic housekeeping: a quarter of the period */
+#define APP_TIMER_SLACK(ticks)		((ticks) / 4)
+
+typedef void (*app_timer_fn)(void);
+
+typedef struct {
+	uint8 id;
+	app_timer_fn handler;
+	dispatch_cost_t cost;
+} app_timer_handler_info_t;
+
+typedef struct {
+	uint8 active;
+	uint8 lazy;
+	uint32 expiries;
+	uint32 wakeups;		/* stack timer events, expiries less batching */
+	uint32 late_ticks;	/* worst expiry after the deadline */
+} app_timer_stats_t;
+
+/* Also takes the soft timer event from event_dispatch */
+void app_timer_init(void);
+/* One handler per handle, a second registration replaces the first */
+bool app_timer_register(uint8 id, app_timer_fn handler);
+/* Expires after time ticks, then every time ticks unless single_shot */
+void app_timer_set(uint32 time, uint8 id, uint8 single_shot);
+/* As app_timer_set(), the expiry may be delayed up to slack ticks to share a
+ * wakeup with the radio or other timers */
+void app_timer_set_lazy(uint32 time, uint32 slack, uint8 id, uint8 single_shot);
+void app_timer_get_stats(app_timer_stats_t *stats);
+/* Handler index-th by handle */
+bool app_timer_get_handler(uint8 index, app_timer_handler_info_t *info);
+void app_timer_clear_costs(void);
+
+#endif /* APP_TIMER_H */
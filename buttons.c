@@ -0,0 +1,144 @@
+/***************************************************************************//**
+ * @file
+ * @brief buttons.c
+ * The GPIO edge interrupt only raises BUTTON_EXT_SIGNAL. The main loop then
+ * debounces with a single shot timer and classifies presses from the stable
+ * pin levels; the timer is only armed while a press is being classified.
+ ******************************************************************************/
+
+#include "em_gpio.h"
+#include "native_gecko.h"
+
+#include "hal-config.h"
+#include "bsphalconfig.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "buttons.h"
+
+typedef struct {
+	GPIO_Port_TypeDef port;
+	uint8 pin;
+	bool pressed;		/* debounced level */
+	bool long_sent;
+	uint8 clicks;		/* short presses waiting for the double press gap */
+	uint32 press_ms;
+	uint32 release_ms;
+} button_t;
+
+static button_t buttons[BUTTON_COUNT] = {
+	{ BSP_BUTTON0_PORT, BSP_BUTTON0_PIN },
+	{ BSP_BUTTON1_PORT, BSP_BUTTON1_PIN },
+};
+static button_handler_t button_handler;
+
+/* Interrupt numbers equal the pin numbers */
+static void button_irq(void) {
+	uint32 flags = GPIO_IntGetEnabled();
+	uint32 mask = (1 << BSP_BUTTON0_PIN) | (1 << BSP_BUTTON1_PIN);
+
+	GPIO_IntClear(flags & mask);
+	if (flags & mask) {
+		gecko_external_signal(BUTTON_EXT_SIGNAL);
+	}
+}
+
+void GPIO_EVEN_IRQHandler(void) {
+	button_irq();
+}
+
+void GPIO_ODD_IRQHandler(void) {
+	button_irq();
+}
+
+void buttons_init(button_handler_t handler) {
+	uint8 i;
+
+	button_handler = handler;
+	app_timer_register(TIMER_ID_BUTTON, buttons_on_timer);
+	for (i = 0; i < BUTTON_COUNT; i++) {
+		GPIO_PinModeSet(buttons[i].port, buttons[i].pin, gpioModeInputPull, 1);
+		buttons[i].pressed = GPIO_PinInGet(buttons[i].port, buttons[i].pin) == 0;
+		buttons[i].long_sent = buttons[i].pressed;
+		buttons[i].clicks = 0;
+		GPIO_ExtIntConfig(buttons[i].port, buttons[i].pin, buttons[i].pin, true,
+				true, true);
+	}
+	NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+	NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+	NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+	NVIC_EnableIRQ(GPIO_ODD_IRQn);
+}
+
+void buttons_process(void) {
+	//Restart the debounce period on every edge
+	app_timer_set(
+			(BUTTON_DEBOUNCE_MS * APP_TIME_TICKS_PER_SEC) / 1000,
+			TIMER_ID_BUTTON, 1);
+}
+
+static void button_report(uint8 index, button_press_t press) {
+	if (button_handler) {
+		button_handler(index, press);
+	}
+}
+
+/* Classify one button, returns ms until it needs to be looked at again or 0 */
+static uint32 button_update(uint8 index, uint32 now) {
+	button_t *b = &buttons[index];
+	bool pressed = GPIO_PinInGet(b->port, b->pin) == 0;
+
+	if (pressed != b->pressed) {
+		b->pressed = pressed;
+		if (pressed) {
+			b->press_ms = now;
+			b->long_sent = false;
+		} else if (!b->long_sent) {
+			b->release_ms = now;
+			if (++b->clicks == 2) {
+				b->clicks = 0;
+				button_report(index, BUTTON_PRESS_DOUBLE);
+			}
+		}
+	}
+
+	if (b->pressed) {
+		if (b->long_sent) {
+			return 0;
+		}
+		if (now - b->press_ms >= BUTTON_LONG_PRESS_MS) {
+			b->long_sent = true;
+			b->clicks = 0;
+			button_report(index, BUTTON_PRESS_LONG);
+			return 0;
+		}
+		return BUTTON_LONG_PRESS_MS - (now - b->press_ms);
+	}
+	if (b->clicks) {
+		if (now - b->release_ms >= BUTTON_DOUBLE_GAP_MS) {
+			b->clicks = 0;
+			button_report(index, BUTTON_PRESS_SHORT);
+			return 0;
+		}
+		return BUTTON_DOUBLE_GAP_MS - (now - b->release_ms);
+	}
+	return 0;
+}
+
+void buttons_on_timer(void) {
+	uint32 now = app_time_ms();
+	uint32 next = 0;
+	uint32 wait;
+	uint8 i;
+
+	for (i = 0; i < BUTTON_COUNT; i++) {
+		wait = button_update(i, now);
+		if (wait && (next == 0 || wait < next)) {
+			next = wait;
+		}
+	}
+	if (next) {
+		app_timer_set(
+				(next * APP_TIME_TICKS_PER_SEC) / 1000 + 1, TIMER_ID_BUTTON, 1);
+	}
+}
@@ -0,0 +1,38 @@
+/***************************************************************************//**
+ * @file
+ * @brief buttons.h
+ * Interrupt driven push buttons with debounce and press classification.
+ ******************************************************************************/
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#define BUTTON_EXT_SIGNAL		0x00000004
+
+#define BUTTON_COUNT			2
+/* The contacts bounce for a few ms after an edge */
+#define BUTTON_DEBOUNCE_MS		20
+/* Held at least this long is a long press, reported while still held */
+#define BUTTON_LONG_PRESS_MS	2000
+/* A second press released within this gap after the first is a double press */
+#define BUTTON_DOUBLE_GAP_MS	400
+
+#define TIMER_ID_BUTTON			86
+
+typedef enum {
+	BUTTON_PRESS_SHORT, BUTTON_PRESS_LONG, BUTTON_PRESS_DOUBLE,
+} button_press_t;
+
+typedef void (*button_handler_t)(uint8 button, button_press_t press);
+
+/* Enable the edge interrupts of both buttons, handler runs in the main loop */
+void buttons_init(button_handler_t handler);
+/* BUTTON_EXT_SIGNAL handler */
+void buttons_process(void);
+/* TIMER_ID_BUTTON handler */
+void buttons_on_timer(void);
+
+#endif /* BUTTONS_H */
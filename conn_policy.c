@@ -0,0 +1,291 @@
+/***************************************************************************//**
+ * @file
+ * @brief conn_policy.c
+ * The proxy profile keeps mesh messages from a phone responsive, the readout
+ * profile trades power for throughput on 2M PHY, the idle profile lets the
+ * radio skip connection events once nobody is talking. The link layer data
+ * length is negotiated by the stack up to its configured maximum, it is only
+ * tracked here.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "event_dispatch.h"
+#include "conn_policy.h"
+
+#define PHY_1M		0x01
+#define PHY_2M		0x02
+
+typedef struct {
+	bool used;
+	bool request_pending;
+	uint32 request_ms;
+	uint32 last_activity_ms;
+	uint32 window_bytes;
+	conn_policy_info_t info;
+} conn_entry_t;
+
+static const conn_profile_t profiles[CONN_PROFILE_COUNT] = {
+	/* 30..50 ms, every event */
+	[CONN_PROFILE_PROXY] = { 24, 40, 0, 200, PHY_1M },
+	/* 7.5..15 ms, every event */
+	[CONN_PROFILE_READOUT] = { 6, 12, 0, 200, PHY_2M },
+	/* 400..500 ms, 4 events may be skipped */
+	[CONN_PROFILE_IDLE] = { 320, 400, 4, 1000, PHY_1M },
+};
+
+static const char *profile_names[CONN_PROFILE_COUNT] = { "proxy", "readout",
+		"idle", };
+
+static conn_entry_t conns[CONN_POLICY_MAX_CONN];
+static uint8 num_open;
+
+static void conn_policy_on_event(struct gecko_cmd_packet *evt);
+
+void conn_policy_init(void) {
+	memset(conns, 0, sizeof(conns));
+	num_open = 0;
+	event_dispatch_register(gecko_evt_le_connection_opened_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_le_connection_closed_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_le_connection_parameters_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_le_connection_phy_status_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_gatt_mtu_exchanged_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_gatt_server_attribute_value_id,
+			conn_policy_on_event);
+	event_dispatch_register(gecko_evt_gatt_server_user_write_request_id,
+			conn_policy_on_event);
+	app_timer_register(TIMER_ID_CONN_POLICY, conn_policy_on_timer);
+}
+
+static conn_entry_t *conn_find(uint8 connection) {
+	uint8 i;
+
+	for (i = 0; i < CONN_POLICY_MAX_CONN; i++) {
+		if (conns[i].used && conns[i].info.connection == connection) {
+			return &conns[i];
+		}
+	}
+	return NULL;
+}
+
+static void conn_apply(conn_entry_t *c, uint8 profile) {
+	const conn_profile_t *p = &profiles[profile];
+	uint16 result;
+
+	c->info.profile = profile;
+	result = gecko_cmd_le_connection_set_parameters(c->info.connection,
+			p->min_interval, p->max_interval, p->latency, p->timeout)->result;
+	if (result) {
+		printf("Conn %d %s parameters refused 0x%x\r\n", c->info.connection,
+				profile_names[profile], result);
+		c->info.rejects++;
+	} else {
+		c->request_pending = true;
+		c->request_ms = app_time_ms();
+	}
+	if (c->info.phy != p->phy) {
+		gecko_cmd_le_connection_set_phy(c->info.connection, p->phy);
+	}
+	//A zero latency profile must not be stretched by the slave latency
+	gecko_cmd_le_connection_disable_slave_latency(c->info.connection,
+			p->latency == 0);
+}
+
+void conn_policy_on_opened(struct gecko_msg_le_connection_opened_evt_t *evt) {
+	conn_entry_t *c = conn_find(evt->connection);
+	uint8 i;
+
+	for (i = 0; c == NULL && i < CONN_POLICY_MAX_CONN; i++) {
+		if (!conns[i].used) {
+			c = &conns[i];
+		}
+	}
+	if (c == NULL) {
+		printf("Conn %d not tracked, table full\r\n", evt->connection);
+		return;
+	}
+	if (!c->used) {
+		num_open++;
+	}
+	memset(c, 0, sizeof(*c));
+	c->used = true;
+	c->last_activity_ms = app_time_ms();
+	c->info.connection = evt->connection;
+	c->info.role = CONN_PROFILE_PROXY;
+	c->info.phy = PHY_1M;
+	c->info.mtu = 23;
+	conn_apply(c, CONN_PROFILE_PROXY);
+
+	if (num_open == 1) {
+		app_timer_set_lazy(CONN_POLICY_TICK_S * APP_TIME_TICKS_PER_SEC,
+				APP_TIMER_SLACK(CONN_POLICY_TICK_S * APP_TIME_TICKS_PER_SEC),
+				TIMER_ID_CONN_POLICY, 0);
+	}
+}
+
+void conn_policy_on_closed(uint8 connection) {
+	conn_entry_t *c = conn_find(connection);
+
+	if (c == NULL) {
+		return;
+	}
+	c->used = false;
+	if (--num_open == 0) {
+		app_timer_set(0, TIMER_ID_CONN_POLICY, 0);
+	}
+}
+
+void conn_policy_on_parameters(
+		struct gecko_msg_le_connection_parameters_evt_t *evt) {
+	conn_entry_t *c = conn_find(evt->connection);
+
+	if (c == NULL) {
+		return;
+	}
+	c->info.interval = evt->interval;
+	c->info.latency = evt->latency;
+	c->info.timeout = evt->timeout;
+	c->info.txsize = evt->txsize;
+	if (c->request_pending) {
+		uint32 elapsed = app_time_ms() - c->request_ms;
+
+		c->request_pending = false;
+		c->info.update_ms = elapsed > 0xffff ? 0xffff : elapsed;
+		c->info.updates++;
+	}
+}
+
+void conn_policy_on_phy(uint8 connection, uint8 phy) {
+	conn_entry_t *c = conn_find(connection);
+
+	if (c != NULL) {
+		c->info.phy = phy;
+	}
+}
+
+void conn_policy_on_mtu(uint8 connection, uint16 mtu) {
+	conn_entry_t *c = conn_find(connection);
+
+	if (c != NULL) {
+		c->info.mtu = mtu;
+	}
+}
+
+void conn_policy_note_traffic(uint8 connection, uint16 bytes) {
+	conn_entry_t *c = conn_find(connection);
+
+	if (c == NULL) {
+		return;
+	}
+	c->info.bytes += bytes;
+	c->window_bytes += bytes;
+	c->last_activity_ms = app_time_ms();
+	c->info.idle_s = 0;
+	c->info.role = CONN_PROFILE_READOUT;
+	if (c->info.profile != CONN_PROFILE_READOUT) {
+		conn_apply(c, CONN_PROFILE_READOUT);
+	}
+}
+
+bool conn_policy_set_role(uint8 connection, conn_profile_id_t role) {
+	conn_entry_t *c = conn_find(connection);
+
+	if (c == NULL || role >= CONN_PROFILE_COUNT) {
+		return false;
+	}
+	if (role != CONN_PROFILE_IDLE) {
+		c->info.role = role;
+		c->last_activity_ms = app_time_ms();
+		c->info.idle_s = 0;
+	}
+	conn_apply(c, role);
+	return true;
+}
+
+void conn_policy_on_timer(void) {
+	uint32 now = app_time_ms();
+	uint8 i;
+
+	for (i = 0; i < CONN_POLICY_MAX_CONN; i++) {
+		conn_entry_t *c = &conns[i];
+		uint32 sample;
+
+		if (!c->used) {
+			continue;
+		}
+		sample = c->window_bytes / CONN_POLICY_TICK_S;
+		c->window_bytes = 0;
+		if (sample > 0xffff) {
+			sample = 0xffff;
+		}
+		c->info.rate = (3 * (uint32) c->info.rate + sample) / 4;
+		if (sample > c->info.peak_rate) {
+			c->info.peak_rate = sample;
+		}
+
+		c->info.idle_s = (now - c->last_activity_ms) / 1000;
+		if (c->info.role == CONN_PROFILE_READOUT
+				&& c->info.profile != CONN_PROFILE_IDLE
+				&& c->info.idle_s >= CONN_POLICY_READOUT_IDLE_S) {
+			conn_apply(c, CONN_PROFILE_IDLE);
+		}
+	}
+}
+
+bool conn_policy_get_info(uint8 index, conn_policy_info_t *info) {
+	uint8 i;
+
+	for (i = 0; i < CONN_POLICY_MAX_CONN; i++) {
+		if (conns[i].used && index-- == 0) {
+			*info = conns[i].info;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void conn_policy_on_event(struct gecko_cmd_packet *evt) {
+	switch (BGLIB_MSG_ID(evt->header)) {
+	case gecko_evt_le_connection_opened_id:
+		conn_policy_on_opened(&evt->data.evt_le_connection_opened);
+		break;
+	case gecko_evt_le_connection_closed_id:
+		conn_policy_on_closed(evt->data.evt_le_connection_closed.connection);
+		break;
+	case gecko_evt_le_connection_parameters_id:
+		conn_policy_on_parameters(&evt->data.evt_le_connection_parameters);
+		break;
+	case gecko_evt_le_connection_phy_status_id:
+		conn_policy_on_phy(evt->data.evt_le_connection_phy_status.connection,
+				evt->data.evt_le_connection_phy_status.phy);
+		break;
+	case gecko_evt_gatt_mtu_exchanged_id:
+		conn_policy_on_mtu(evt->data.evt_gatt_mtu_exchanged.connection,
+				evt->data.evt_gatt_mtu_exchanged.mtu);
+		break;
+	case gecko_evt_gatt_server_attribute_value_id:
+		conn_policy_note_traffic(
+				evt->data.evt_gatt_server_attribute_value.connection,
+				evt->data.evt_gatt_server_attribute_value.value.len);
+		break;
+	case gecko_evt_gatt_server_user_write_request_id:
+		conn_policy_note_traffic(
+				evt->data.evt_gatt_server_user_write_request.connection,
+				evt->data.evt_gatt_server_user_write_request.value.len);
+		break;
+	default:
+		break;
+	}
+}
+
+const char *conn_policy_profile_name(uint8 profile) {
+	return profile < CONN_PROFILE_COUNT ? profile_names[profile] : "?";
+}
@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file
+ * @brief conn_policy.h
+ * Connection parameters and PHY of the GATT connections chosen by role.
+ ******************************************************************************/
+
+#ifndef CONN_POLICY_H
+#define CONN_POLICY_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+#define CONN_POLICY_MAX_CONN		4
+
+/* Idle check and throughput sample period while connections are open */
+#define CONN_POLICY_TICK_S			1
+/* Without GATT traffic for this long a readout drops to the idle profile. Proxy
+ * traffic is handled by the stack and never seen here, so a proxy connection
+ * is never idled. */
+#define CONN_POLICY_READOUT_IDLE_S	5
+
+#define TIMER_ID_CONN_POLICY		88
+
+/* A connection starts as proxy, GATT traffic of our own database makes it a
+ * readout, which falls back to CONN_PROFILE_IDLE. */
+typedef enum {
+	CONN_PROFILE_PROXY,
+	CONN_PROFILE_READOUT,
+	CONN_PROFILE_IDLE,
+	CONN_PROFILE_COUNT,
+} conn_profile_id_t;
+
+typedef struct {
+	uint16 min_interval;	/* 1.25 ms units */
+	uint16 max_interval;
+	uint16 latency;			/* connection events */
+	uint16 timeout;			/* 10 ms units */
+	uint8 phy;				/* le_connection_set_phy mask */
+} conn_profile_t;
+
+typedef struct {
+	uint8 connection;
+	uint8 role;			/* CONN_PROFILE_PROXY or CONN_PROFILE_READOUT */
+	uint8 profile;		/* profile last requested */
+	uint8 phy;
+	uint16 interval;	/* in effect, 1.25 ms units */
+	uint16 latency;
+	uint16 timeout;
+	uint16 txsize;		/* link layer data length */
+	uint16 mtu;
+	uint16 update_ms;	/* request to parameters event, last update */
+	uint16 rate;		/* bytes/s, smoothed */
+	uint16 peak_rate;
+	uint32 bytes;
+	uint32 updates;
+	uint32 rejects;		/* requests the stack refused */
+	uint32 idle_s;
+} conn_policy_info_t;
+
+/* Registers for the connection and GATT events it follows */
+void conn_policy_init(void);
+void conn_policy_on_opened(struct gecko_msg_le_connection_opened_evt_t *evt);
+void conn_policy_on_closed(uint8 connection);
+void conn_policy_on_parameters(
+		struct gecko_msg_le_connection_parameters_evt_t *evt);
+void conn_policy_on_phy(uint8 connection, uint8 phy);
+void conn_policy_on_mtu(uint8 connection, uint16 mtu);
+/* GATT bytes of our own database, turns the connection into a readout */
+void conn_policy_note_traffic(uint8 connection, uint16 bytes);
+/* Force a role, CONN_PROFILE_IDLE parks the connection until traffic */
+bool conn_policy_set_role(uint8 connection, conn_profile_id_t role);
+/* TIMER_ID_CONN_POLICY handler */
+void conn_policy_on_timer(void);
+/* Connection index-th open connection, false past the last one */
+bool conn_policy_get_info(uint8 index, conn_policy_info_t *info);
+const char *conn_policy_profile_name(uint8 profile);
+
+#endif /* CONN_POLICY_H */
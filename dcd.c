@@ -32,14 +32,16 @@ const uint8_t __mesh_dcd[] = {
     0x07, 0x00, /* Features Bitmask = 0x0007 */
     /* Begin Primary Element */
         0x00, 0x00, /* Location = 0x0000 */
-        0x03, /* Number of SIG Models = 0x03 */
-        0x00, /* Number of Vendor Models = 0x00 */
+        0x04, /* Number of SIG Models = 0x04 */
+        0x01, /* Number of Vendor Models = 0x01 */
         /* Begin SIG Models */
         0x00, 0x00, /* Configuration Server */
         0x02, 0x10, /* Generic Level Server */
         0x03, 0x10, /* Generic Level Client */
+        0x00, 0x11, /* Sensor Server */
         /* End SIG Models */
         /* Begin Vendor Models */
+        0xff, 0x02, 0x01, 0x00, /* Vendor 0x02ff Model 0x0001 */
         /* End Vendor Models */
     /* End Primary Element */
 };
@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file
+ * @brief dedup_cache.c
+ * The generic server event does not expose the transaction identifier, so an
+ * entry is keyed on the source address and the 16 bit level and expires after
+ * a short window. Entries are kept in a small set associative
+ * table: a lookup touches only the DEDUP_CACHE_WAYS slots of one set.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "app_time.h"
+#include "dedup_cache.h"
+
+typedef struct {
+	uint16 source;		/* 0 marks an empty slot, never a valid unicast */
+	uint16 level;
+	uint32 time_ms;
+} dedup_entry_t;
+
+static dedup_entry_t dedup_table[DEDUP_CACHE_SETS][DEDUP_CACHE_WAYS];
+static dedup_cache_stats_t dedup_stats;
+static uint32 dedup_window_ms = DEDUP_WINDOW_MS_DEFAULT;
+
+void dedup_cache_init(uint32 window_ms) {
+	memset(dedup_table, 0, sizeof(dedup_table));
+	memset(&dedup_stats, 0, sizeof(dedup_stats));
+	dedup_window_ms = window_ms;
+}
+
+bool dedup_cache_check(uint16 source, uint16 level) {
+	//Both bytes of the level take part in the set choice
+	dedup_entry_t *set = dedup_table[(source ^ level ^ (level >> 8))
+			& (DEDUP_CACHE_SETS - 1)];
+	dedup_entry_t *victim = &set[0];
+	uint32 now = app_time_ms();
+	uint8 i;
+
+	for (i = 0; i < DEDUP_CACHE_WAYS; i++) {
+		dedup_entry_t *e = &set[i];
+		if (e->source == source && e->level == level) {
+			if ((uint32) (now - e->time_ms) < dedup_window_ms) {
+				dedup_stats.hits++;
+				return true;
+			}
+			//Same message after the window, refresh its entry
+			victim = e;
+			break;
+		}
+		//Prefer an empty slot, else evict the oldest one
+		if (victim->source != 0
+				&& (e->source == 0
+						|| (uint32) (now - e->time_ms)
+								> (uint32) (now - victim->time_ms))) {
+			victim = e;
+		}
+	}
+
+	victim->source = source;
+	victim->level = level;
+	victim->time_ms = now;
+	dedup_stats.misses++;
+	return false;
+}
+
+void dedup_cache_get_stats(dedup_cache_stats_t *stats) {
+	*stats = dedup_stats;
+}
+
+void dedup_cache_clear_stats(void) {
+	memset(&dedup_stats, 0, sizeof(dedup_stats));
+}
@@ -0,0 +1,32 @@
+/***************************************************************************//**
+ * @file
+ * @brief dedup_cache.h
+ * Recent message cache used to drop repeated Generic Level reports.
+ ******************************************************************************/
+
+#ifndef DEDUP_CACHE_H
+#define DEDUP_CACHE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Cache geometry, DEDUP_CACHE_SETS must be a power of two */
+#define DEDUP_CACHE_SETS		8
+#define DEDUP_CACHE_WAYS		4
+
+/* A copy arriving within this window of the first one is a duplicate */
+#define DEDUP_WINDOW_MS_DEFAULT	3000
+
+typedef struct {
+	uint32 hits;
+	uint32 misses;
+} dedup_cache_stats_t;
+
+void dedup_cache_init(uint32 window_ms);
+/* Returns true if (source, level) was already seen inside the window,
+ * otherwise records it and returns false */
+bool dedup_cache_check(uint16 source, uint16 level);
+void dedup_cache_get_stats(dedup_cache_stats_t *stats);
+void dedup_cache_clear_stats(void);
+
+#endif /* DEDUP_CACHE_H */
@@ -0,0 +1,283 @@
+/***************************************************************************//**
+ * @file
+ * @brief env_sensor.c
+ * Measurements use the no-hold commands of the Si7013 so the BGAPI loop never
+ * waits for a conversion: the cadence timer starts one, a single shot timer
+ * collects the result ENV_SENSOR_CONVERSION_MS later. The I2C transfers are
+ * queued on the interrupt driven driver and complete through callbacks. A
+ * result is published through the model publication only when it moved past
+ * the thresholds.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hal-config.h"
+#include "i2cspm.h"
+#include "i2casync.h"
+#include "si7013.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "event_dispatch.h"
+#include "env_sensor.h"
+
+/* Client address 0 sends a status through the model publication */
+#define SENSOR_PUBLISH_ADDRESS		0x0000
+#define SENSOR_NO_FLAGS				0
+
+#define SENSOR_SAMPLING_INSTANTANEOUS	0x01
+
+/* Temperature 8 is 0.5 C steps from -64.0 to 63.0 C, 0x7f is reserved for
+ * an unknown value. The Si7013 reads up to 125 C, readings outside the
+ * format saturate. */
+#define TEMPERATURE8_MIN			(-128)
+#define TEMPERATURE8_MAX			126
+
+typedef enum {
+	SENSOR_IDLE, SENSOR_CONVERTING,
+} env_sensor_phase_t;
+
+static env_sensor_state_t sensor;
+static env_sensor_phase_t phase;
+static uint8 read_retries;
+static uint16 sensor_elem_index;
+static uint8 sensor_addr;
+
+static int8 published_temperature;
+static uint16 published_humidity;
+static bool published;
+
+static void env_sensor_on_event(struct gecko_cmd_packet *evt);
+static void env_sensor_on_cadence(void);
+static void env_sensor_on_read(void);
+
+void env_sensor_init(void) {
+	memset(&sensor, 0, sizeof(sensor));
+	sensor.cadence_s = ENV_SENSOR_CADENCE_S_DEFAULT;
+	sensor.temp_delta = ENV_SENSOR_TEMP_DELTA_DEFAULT;
+	sensor.rh_delta = ENV_SENSOR_RH_DELTA_DEFAULT;
+	phase = SENSOR_IDLE;
+	published = false;
+	event_dispatch_register(gecko_evt_mesh_sensor_server_get_request_id,
+			env_sensor_on_event);
+	event_dispatch_register(gecko_evt_mesh_sensor_server_publish_id,
+			env_sensor_on_event);
+	app_timer_register(TIMER_ID_SENSOR, env_sensor_on_cadence);
+	app_timer_register(TIMER_ID_SENSOR_READ, env_sensor_on_read);
+}
+
+static void put_descriptor(uint8 *d, uint16 property_id) {
+	d[0] = property_id & 0xff;
+	d[1] = property_id >> 8;
+	d[2] = 0; /* positive and negative tolerance unspecified */
+	d[3] = 0;
+	d[4] = 0;
+	d[5] = SENSOR_SAMPLING_INSTANTANEOUS;
+	d[6] = 0; /* measurement period not applicable */
+	d[7] = 0; /* update interval not applicable */
+}
+
+void env_sensor_start(uint16 elem_index) {
+	uint8 descriptors[2 * 8];
+	uint8 device_id;
+	uint16 result;
+
+	sensor_elem_index = elem_index;
+	put_descriptor(&descriptors[0], PROPERTY_PRESENT_AMBIENT_TEMPERATURE);
+	put_descriptor(&descriptors[8], PROPERTY_PRESENT_AMBIENT_HUMIDITY);
+	result = gecko_cmd_mesh_sensor_server_init(elem_index, sizeof(descriptors),
+			descriptors)->result;
+	if (result) {
+		printf("Sensor server init failed 0x%x !!!\r\n", result);
+		return;
+	}
+
+	if (Si7013_Detect(I2C0, SI7021_ADDR, &device_id)) {
+		sensor_addr = SI7021_ADDR;
+	} else if (Si7013_Detect(I2C0, SI7013_ADDR, &device_id)) {
+		sensor_addr = SI7013_ADDR;
+	} else {
+		printf("No Si70xx sensor found !!!\r\n");
+		return;
+	}
+	sensor.present = true;
+	printf("Si70xx sensor %x found\r\n", device_id);
+
+	app_timer_set_lazy(sensor.cadence_s * APP_TIME_TICKS_PER_SEC,
+			APP_TIMER_SLACK(sensor.cadence_s * APP_TIME_TICKS_PER_SEC),
+			TIMER_ID_SENSOR, 0);
+}
+
+void env_sensor_set_cadence(uint16 cadence_s) {
+	if (cadence_s == 0) {
+		return;
+	}
+	sensor.cadence_s = cadence_s;
+	if (sensor.present) {
+		app_timer_set_lazy(sensor.cadence_s * APP_TIME_TICKS_PER_SEC,
+				APP_TIMER_SLACK(sensor.cadence_s * APP_TIME_TICKS_PER_SEC),
+				TIMER_ID_SENSOR, 0);
+	}
+}
+
+void env_sensor_set_thresholds(uint8 temp_delta, uint16 rh_delta) {
+	sensor.temp_delta = temp_delta;
+	sensor.rh_delta = rh_delta;
+}
+
+void env_sensor_get_state(env_sensor_state_t *state) {
+	*state = sensor;
+}
+
+/* TLV serialized sensor data: property id, length, value */
+static uint8 env_sensor_serialize(uint16 property_id, uint8 *buf) {
+	uint8 len = 0;
+
+	if (property_id == 0 || property_id == PROPERTY_PRESENT_AMBIENT_TEMPERATURE) {
+		buf[len++] = PROPERTY_PRESENT_AMBIENT_TEMPERATURE & 0xff;
+		buf[len++] = PROPERTY_PRESENT_AMBIENT_TEMPERATURE >> 8;
+		buf[len++] = 1;
+		buf[len++] = (uint8) sensor.temperature;
+	}
+	if (property_id == 0 || property_id == PROPERTY_PRESENT_AMBIENT_HUMIDITY) {
+		buf[len++] = PROPERTY_PRESENT_AMBIENT_HUMIDITY & 0xff;
+		buf[len++] = PROPERTY_PRESENT_AMBIENT_HUMIDITY >> 8;
+		buf[len++] = 2;
+		buf[len++] = sensor.humidity & 0xff;
+		buf[len++] = sensor.humidity >> 8;
+	}
+	return len;
+}
+
+static void env_sensor_send(uint16 client_address, uint16 appkey_index,
+		uint16 property_id) {
+	uint8 buf[9];
+	uint8 len = env_sensor_serialize(property_id, buf);
+	uint16 result = gecko_cmd_mesh_sensor_server_send_status(sensor_elem_index,
+			client_address, appkey_index, SENSOR_NO_FLAGS, len, buf)->result;
+
+	if (result) {
+		printf("Sensor status failed 0x%x !!!\r\n", result);
+	}
+}
+
+static bool env_sensor_moved(void) {
+	int16 dt = sensor.temperature - published_temperature;
+	int32 drh = (int32) sensor.humidity - published_humidity;
+
+	if (!published) {
+		return true;
+	}
+	return (dt < 0 ? -dt : dt) >= sensor.temp_delta
+			|| (drh < 0 ? -drh : drh) >= sensor.rh_delta;
+}
+
+static void env_sensor_schedule_read(void) {
+	app_timer_set(
+			(ENV_SENSOR_CONVERSION_MS * APP_TIME_TICKS_PER_SEC) / 1000,
+			TIMER_ID_SENSOR_READ, 1);
+}
+
+static void env_sensor_collected(int32_t ret, uint32_t rh_milli,
+		int32_t t_milli, void *user) {
+	(void) user;
+	if (ret) {
+		//Conversion not finished yet or bus error
+		if (read_retries++ < ENV_SENSOR_READ_RETRIES) {
+			env_sensor_schedule_read();
+			return;
+		}
+		sensor.errors++;
+		phase = SENSOR_IDLE;
+		return;
+	}
+	phase = SENSOR_IDLE;
+	sensor.measurements++;
+	t_milli /= 500;
+	if (t_milli < TEMPERATURE8_MIN) {
+		t_milli = TEMPERATURE8_MIN;
+	} else if (t_milli > TEMPERATURE8_MAX) {
+		t_milli = TEMPERATURE8_MAX;
+	}
+	sensor.temperature = (int8) t_milli;
+	//The driver offset can push dry readings below zero
+	if ((int32) rh_milli < 0) {
+		rh_milli = 0;
+	} else if (rh_milli > 100000) {
+		rh_milli = 100000;
+	}
+	sensor.humidity = (uint16) (rh_milli / 10);
+
+	if (env_sensor_moved()) {
+		env_sensor_send(SENSOR_PUBLISH_ADDRESS, 0, 0);
+		published_temperature = sensor.temperature;
+		published_humidity = sensor.humidity;
+		published = true;
+		sensor.publications++;
+	}
+}
+
+static void env_sensor_started(int32_t ret, uint32_t rh_milli,
+		int32_t t_milli, void *user) {
+	(void) rh_milli;
+	(void) t_milli;
+	(void) user;
+	if (ret) {
+		sensor.errors++;
+		phase = SENSOR_IDLE;
+		return;
+	}
+	read_retries = 0;
+	env_sensor_schedule_read();
+}
+
+void env_sensor_on_timer(uint8 handle) {
+	if (!sensor.present) {
+		return;
+	}
+	if (handle == TIMER_ID_SENSOR) {
+		if (phase != SENSOR_IDLE) {
+			return;
+		}
+		if (Si7013_StartNoHoldMeasureRHAndTempAsync(I2C0, sensor_addr,
+				env_sensor_started, NULL)) {
+			sensor.errors++;
+			return;
+		}
+		phase = SENSOR_CONVERTING;
+	} else if (handle == TIMER_ID_SENSOR_READ) {
+		if (Si7013_ReadNoHoldRHAndTempAsync(I2C0, sensor_addr,
+				env_sensor_collected, NULL)) {
+			sensor.errors++;
+			phase = SENSOR_IDLE;
+		}
+	}
+}
+
+static void env_sensor_on_cadence(void) {
+	env_sensor_on_timer(TIMER_ID_SENSOR);
+}
+
+static void env_sensor_on_read(void) {
+	env_sensor_on_timer(TIMER_ID_SENSOR_READ);
+}
+
+void env_sensor_on_get_request(
+		struct gecko_msg_mesh_sensor_server_get_request_evt_t *req) {
+	env_sensor_send(req->client_address, req->appkey_index, req->property_id);
+}
+
+void env_sensor_on_publish(void) {
+	if (published) {
+		env_sensor_send(SENSOR_PUBLISH_ADDRESS, 0, 0);
+	}
+}
+
+static void env_sensor_on_event(struct gecko_cmd_packet *evt) {
+	if (BGLIB_MSG_ID(evt->header) == gecko_evt_mesh_sensor_server_get_request_id) {
+		env_sensor_on_get_request(&evt->data.evt_mesh_sensor_server_get_request);
+	} else {
+		env_sensor_on_publish();
+	}
+}
@@ -0,0 +1,55 @@
+/***************************************************************************//**
+ * @file
+ * @brief env_sensor.h
+ * Si7013/Si7021 temperature and humidity exposed through the Sensor Server.
+ ******************************************************************************/
+
+#ifndef ENV_SENSOR_H
+#define ENV_SENSOR_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+/* Mesh device properties */
+#define PROPERTY_PRESENT_AMBIENT_TEMPERATURE	0x004F	/* int8, 0.5 degC */
+#define PROPERTY_PRESENT_AMBIENT_HUMIDITY		0x0076	/* uint16, 0.01 % */
+
+#define ENV_SENSOR_CADENCE_S_DEFAULT	30
+/* Publish only when a value moved this much since the last publication */
+#define ENV_SENSOR_TEMP_DELTA_DEFAULT	2		/* 0.5 degC steps */
+#define ENV_SENSOR_RH_DELTA_DEFAULT		200		/* 0.01 % steps */
+
+/* Conversion time of RH plus temperature is below 25 ms */
+#define ENV_SENSOR_CONVERSION_MS		30
+#define ENV_SENSOR_READ_RETRIES			3
+
+#define TIMER_ID_SENSOR					84
+#define TIMER_ID_SENSOR_READ			85
+
+typedef struct {
+	bool present;
+	int8 temperature;	/* last measurement, property encoding */
+	uint16 humidity;
+	uint16 cadence_s;
+	uint8 temp_delta;
+	uint16 rh_delta;
+	uint32 measurements;
+	uint32 errors;
+	uint32 publications;
+} env_sensor_state_t;
+
+void env_sensor_init(void);
+/* Register the Sensor Server model and start the measurement cadence */
+void env_sensor_start(uint16 elem_index);
+void env_sensor_set_cadence(uint16 cadence_s);
+void env_sensor_set_thresholds(uint8 temp_delta, uint16 rh_delta);
+void env_sensor_get_state(env_sensor_state_t *state);
+
+/* TIMER_ID_SENSOR and TIMER_ID_SENSOR_READ handler */
+void env_sensor_on_timer(uint8 handle);
+void env_sensor_on_get_request(
+		struct gecko_msg_mesh_sensor_server_get_request_evt_t *req);
+void env_sensor_on_publish(void);
+
+#endif /* ENV_SENSOR_H */
@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ * @file
+ * @brief event_dispatch.c
+ * Registration happens at init, dispatch on every event: the table is kept
+ * sorted by event id on insert and searched by bisection.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "event_dispatch.h"
+
+static event_dispatch_info_t table[EVENT_DISPATCH_MAX];
+static uint8 table_len;
+
+void event_dispatch_init(void) {
+	memset(table, 0, sizeof(table));
+	table_len = 0;
+}
+
+/* First entry with an id not below evt_id */
+static uint8 lower_bound(uint32 evt_id) {
+	uint8 lo = 0;
+	uint8 hi = table_len;
+
+	while (lo < hi) {
+		uint8 mid = (lo + hi) / 2;
+
+		if (table[mid].evt_id < evt_id) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+bool event_dispatch_register(uint32 evt_id, event_handler_fn handler) {
+	uint8 pos = lower_bound(evt_id);
+
+	//After the handlers already there for the event
+	for (; pos < table_len && table[pos].evt_id == evt_id; pos++) {
+		if (table[pos].handler == handler) {
+			return true;
+		}
+	}
+	if (table_len >= EVENT_DISPATCH_MAX) {
+		return false;
+	}
+	memmove(&table[pos + 1], &table[pos], (table_len - pos) * sizeof(table[0]));
+	memset(&table[pos], 0, sizeof(table[0]));
+	table[pos].evt_id = evt_id;
+	table[pos].handler = handler;
+	table_len++;
+	return true;
+}
+
+bool event_dispatch(uint32 evt_id, struct gecko_cmd_packet *evt) {
+	uint8 pos = lower_bound(evt_id);
+	bool handled = false;
+
+	for (; pos < table_len && table[pos].evt_id == evt_id; pos++) {
+		DISPATCH_TIMED(&table[pos].cost, table[pos].handler(evt));
+		handled = true;
+	}
+	return handled;
+}
+
+bool event_dispatch_get(uint8 index, event_dispatch_info_t *info) {
+	if (index >= table_len) {
+		return false;
+	}
+	*info = table[index];
+	return true;
+}
+
+void event_dispatch_clear_costs(void) {
+	uint8 i;
+
+	for (i = 0; i < table_len; i++) {
+		memset(&table[i].cost, 0, sizeof(table[i].cost));
+	}
+}
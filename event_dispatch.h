@@ -0,0 +1,65 @@
+/***************************************************************************//**
+ * @file
+ * @brief event_dispatch.h
+ * Stack events routed to the handlers modules register for them.
+ ******************************************************************************/
+
+#ifndef EVENT_DISPATCH_H
+#define EVENT_DISPATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+#include "prof.h"
+
+#define EVENT_DISPATCH_MAX		40
+
+typedef void (*event_handler_fn)(struct gecko_cmd_packet *evt);
+
+/* Cost of one handler, kept when built with APP_PROFILE */
+typedef struct {
+	uint32 count;
+	uint32 max_cycles;
+	uint64_t total_cycles;
+} dispatch_cost_t;
+
+typedef struct {
+	uint32 evt_id;
+	event_handler_fn handler;
+	dispatch_cost_t cost;
+} event_dispatch_info_t;
+
+#if APP_PROFILE
+/* Times handler into cost */
+#define DISPATCH_TIMED(cost, call) do { \
+		uint32 dispatch_start = DWT->CYCCNT; \
+		uint32 dispatch_cycles; \
+		call; \
+		dispatch_cycles = DWT->CYCCNT - dispatch_start; \
+		(cost)->count++; \
+		(cost)->total_cycles += dispatch_cycles; \
+		if (dispatch_cycles > (cost)->max_cycles) { \
+			(cost)->max_cycles = dispatch_cycles; \
+		} \
+	} while (0)
+#else
+#define DISPATCH_TIMED(cost, call) do { \
+		(cost)->count++; \
+		call; \
+	} while (0)
+#endif
+
+void event_dispatch_init(void);
+/* Handlers of one event run in registration order. Registering the same
+ * handler twice for an event is a no-op. False when the table is full. Not
+ * to be called from a handler of the same event. */
+bool event_dispatch_register(uint32 evt_id, event_handler_fn handler);
+/* False if no handler took the event */
+bool event_dispatch(uint32 evt_id, struct gecko_cmd_packet *evt);
+/* Entry index-th of the table, by event id */
+bool event_dispatch_get(uint8 index, event_dispatch_info_t *info);
+void event_dispatch_clear_costs(void);
+
+#endif /* EVENT_DISPATCH_H */
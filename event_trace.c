@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief event_trace.c
+ * Recording is a register read and a 16 byte copy so it can stay on for
+ * every event. The RTCC runs at 32768 Hz from boot, reading it directly
+ * avoids a gecko_cmd_hardware_get_time() round trip per event.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "em_rtcc.h"
+
+#include "event_trace.h"
+
+static event_trace_entry_t ring[EVENT_TRACE_DEPTH];
+static uint32 recorded;
+static bool trace_on;
+
+void event_trace_init(void) {
+	event_trace_clear();
+	trace_on = true;
+}
+
+void event_trace_enable(bool enable) {
+	trace_on = enable;
+}
+
+bool event_trace_enabled(void) {
+	return trace_on;
+}
+
+void event_trace_clear(void) {
+	memset(ring, 0, sizeof(ring));
+	recorded = 0;
+}
+
+void event_trace_record(const struct gecko_cmd_packet *evt) {
+	event_trace_entry_t *e;
+	uint16 len;
+
+	if (!trace_on) {
+		return;
+	}
+	e = &ring[recorded & (EVENT_TRACE_DEPTH - 1)];
+	e->header = evt->header;
+	e->time = RTCC_CounterGet();
+	len = BGLIB_MSG_LEN(evt->header);
+	if (len > EVENT_TRACE_DATA_LEN) {
+		len = EVENT_TRACE_DATA_LEN;
+	}
+	memcpy(e->data, &evt->data, len);
+	memset(&e->data[len], 0, EVENT_TRACE_DATA_LEN - len);
+	recorded++;
+}
+
+uint16 event_trace_count(void) {
+	return recorded < EVENT_TRACE_DEPTH ? recorded : EVENT_TRACE_DEPTH;
+}
+
+static void dump_line(const void *p, uint16 len) {
+	const uint8 *b = p;
+	uint16 i;
+
+	printf("TRACE ");
+	for (i = 0; i < len; i++) {
+		printf("%02x", b[i]);
+	}
+	printf("\r\n");
+}
+
+void event_trace_dump(void) {
+	event_trace_header_t h;
+	uint32 first;
+	uint16 i;
+
+	h.magic = EVENT_TRACE_MAGIC;
+	h.count = event_trace_count();
+	h.entry_size = sizeof(event_trace_entry_t);
+	h.tick_hz = EVENT_TRACE_TICK_HZ;
+	h.overwritten = recorded - h.count;
+	first = recorded - h.count;
+
+	dump_line(&h, sizeof(h));
+	for (i = 0; i < h.count; i++) {
+		dump_line(&ring[(first + i) & (EVENT_TRACE_DEPTH - 1)],
+				sizeof(event_trace_entry_t));
+	}
+}
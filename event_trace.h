@@ -0,0 +1,52 @@
+/***************************************************************************//**
+ * @file
+ * @brief event_trace.h
+ * Ring of the BGAPI events seen by handle_gecko_event, dumped for offline
+ * decoding with trace_decode.py.
+ ******************************************************************************/
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+/* Entries kept, must be a power of two */
+#define EVENT_TRACE_DEPTH		64
+/* Leading payload bytes kept per event, they hold the handles and addresses
+ * most events start with */
+#define EVENT_TRACE_DATA_LEN	8
+/* RTCC counter rate */
+#define EVENT_TRACE_TICK_HZ		32768
+
+/* Dump layout, little endian: one event_trace_header_t then count entries
+ * oldest first. A host replay build rebuilds each event from the header word
+ * and the leading payload, longer payloads are truncated. */
+#define EVENT_TRACE_MAGIC		0x31525445	/* "ETR1" */
+
+typedef struct {
+	uint32 magic;
+	uint16 count;
+	uint16 entry_size;
+	uint32 tick_hz;
+	uint32 overwritten;	/* events lost to wrap around before the oldest */
+} event_trace_header_t;
+
+typedef struct {
+	uint32 header;		/* BGAPI header, id and payload length */
+	uint32 time;		/* RTCC ticks */
+	uint8 data[EVENT_TRACE_DATA_LEN];
+} event_trace_entry_t;
+
+void event_trace_init(void);
+void event_trace_enable(bool enable);
+bool event_trace_enabled(void);
+void event_trace_clear(void);
+/* Called first thing for every event passed to handle_gecko_event */
+void event_trace_record(const struct gecko_cmd_packet *evt);
+/* Print the dump as "TRACE <hex>" lines, one header or entry per line */
+void event_trace_dump(void);
+uint16 event_trace_count(void);
+
+#endif /* EVENT_TRACE_H */
@@ -27,6 +27,7 @@
 
 /* Own header */
 #include "graphics.h"
+#include "prof.h"
 
 /***************************************************************************************************
  Local Variables
@@ -80,6 +81,8 @@ void graphInit(char *header) {
 }
 
 void graphWriteString(char *string) {
+	PROF_SCOPE(PROF_GRAPH_WRITE);
+
 	GLIB_clear(&glibContext);
 
 	/* Reset line number, print header and device name */
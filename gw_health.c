@@ -0,0 +1,149 @@
+/***************************************************************************//**
+ * @file
+ * @brief gw_health.c
+ * The stack keeps one heartbeat subscription at a time and reports only at
+ * the end of its window, with the count and hop range of what it received.
+ * The window is renewed on every completion, normally on the active gateway.
+ * On the backup, the primary is probed every GW_HEALTH_PROBE_WINDOWS windows
+ * and taken back as soon as it is heard.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_time.h"
+#include "gw_health.h"
+
+static gw_health_info_t gws[GW_HEALTH_NUM];
+static uint8 active;
+static uint8 watched;
+static uint32 backup_windows;
+static bool started;
+
+void gw_health_init(void) {
+	uint8 i;
+
+	memset(gws, 0, sizeof(gws));
+	gws[0].address = GW_HEALTH_PRIMARY;
+	gws[1].address = GW_HEALTH_BACKUP;
+	for (i = 0; i < GW_HEALTH_NUM; i++) {
+		gws[i].alive = true;
+	}
+	active = 0;
+	watched = 0;
+	backup_windows = 0;
+	started = false;
+}
+
+static int8 gw_index(uint16 address) {
+	uint8 i;
+
+	for (i = 0; i < GW_HEALTH_NUM; i++) {
+		if (gws[i].address == address) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void gw_health_restore(uint16 address, uint8 misses) {
+	int8 i = gw_index(address);
+
+	if (i < 0) {
+		return;
+	}
+	active = i;
+	watched = i;
+	gws[i].misses = misses;
+}
+
+static void gw_subscribe(void) {
+	uint16 result = gecko_cmd_mesh_test_set_local_heartbeat_subscription(
+			gws[watched].address, GW_HEALTH_HB_DST, GW_HEALTH_PERIOD_LOG)->result;
+
+	if (result) {
+		printf("Heartbeat subscription to %x failed 0x%x !!!\r\n",
+				gws[watched].address, result);
+	}
+}
+
+void gw_health_start(void) {
+	started = true;
+	gw_subscribe();
+}
+
+bool gw_health_is_gateway(uint16 address) {
+	return gw_index(address) >= 0;
+}
+
+static void gw_alive(gw_health_info_t *gw) {
+	gw->alive = true;
+	gw->misses = 0;
+	gw->last_seen_ms = app_time_ms();
+}
+
+void gw_health_note_traffic(uint16 address) {
+	int8 i = gw_index(address);
+
+	if (i >= 0) {
+		gw_alive(&gws[i]);
+	}
+}
+
+bool gw_health_on_complete(
+		struct gecko_msg_mesh_test_local_heartbeat_subscription_complete_evt_t *evt) {
+	gw_health_info_t *gw = &gws[watched];
+	uint8 last_active = active;
+
+	if (!started) {
+		return false;
+	}
+	gw->windows++;
+	gw->received += evt->count;
+	gw->expected += GW_HEALTH_PERIOD_S / GW_HEALTH_GW_PERIOD_S;
+	gw->loss_pct = gw->received >= gw->expected ?
+			0 : 100 - (gw->received * 100) / gw->expected;
+	if (evt->count) {
+		gw->hop_min = evt->hop_min;
+		gw->hop_max = evt->hop_max;
+		gw_alive(gw);
+	} else if (gw->misses < 0xff && ++gw->misses >= GW_HEALTH_MISS_LIMIT) {
+		gw->alive = false;
+	}
+
+	if (watched == active && !gw->alive) {
+		//Fail over, the other gateway is given the benefit of the doubt
+		active = (active + 1) % GW_HEALTH_NUM;
+		gws[active].alive = true;
+		gws[active].misses = 0;
+		backup_windows = 0;
+	} else if (watched == 0 && active != 0 && gw->alive) {
+		active = 0;
+	}
+
+	if (active != 0 && ++backup_windows % GW_HEALTH_PROBE_WINDOWS == 0) {
+		watched = 0;
+	} else {
+		watched = active;
+	}
+	gw_subscribe();
+
+	if (active != last_active) {
+		printf("Gateway %x -> %x\r\n", gws[last_active].address,
+				gws[active].address);
+		return true;
+	}
+	return false;
+}
+
+uint16 gw_health_active(void) {
+	return gws[active].address;
+}
+
+bool gw_health_get(uint8 index, gw_health_info_t *info) {
+	if (index >= GW_HEALTH_NUM) {
+		return false;
+	}
+	*info = gws[index];
+	return true;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************//**
+ * @file
+ * @brief gw_health.h
+ * Gateway liveness from mesh heartbeats, failover between the primary and
+ * the backup gateway.
+ ******************************************************************************/
+
+#ifndef GW_HEALTH_H
+#define GW_HEALTH_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+#define GW_HEALTH_PRIMARY			0x0001
+#define GW_HEALTH_BACKUP			0x0002
+#define GW_HEALTH_NUM				2
+
+/* Group address the gateways publish their heartbeats to */
+#define GW_HEALTH_HB_DST			0xc0fe
+/* Subscription window of 2^(log - 1) s */
+#define GW_HEALTH_PERIOD_LOG		6
+#define GW_HEALTH_PERIOD_S			(1 << (GW_HEALTH_PERIOD_LOG - 1))
+/* Heartbeat publication period the gateways are configured with, the
+ * expected count of a window and so the loss rate derive from it */
+#define GW_HEALTH_GW_PERIOD_S		8
+/* Windows without heartbeat or traffic before a gateway is dead */
+#define GW_HEALTH_MISS_LIMIT		2
+/* While on the backup, every n-th window watches the primary instead */
+#define GW_HEALTH_PROBE_WINDOWS		4
+
+typedef struct {
+	uint16 address;
+	bool alive;
+	uint8 misses;		/* consecutive windows without sign of life */
+	uint8 hop_min;		/* of the last window with heartbeats */
+	uint8 hop_max;
+	uint16 loss_pct;	/* heartbeats lost over all watched windows */
+	uint32 windows;		/* windows this gateway was watched */
+	uint32 received;
+	uint32 expected;
+	uint32 last_seen_ms;
+} gw_health_info_t;
+
+void gw_health_init(void);
+/* Continue with the gateway state of a warm restart */
+void gw_health_restore(uint16 active, uint8 misses);
+/* Subscribe to the heartbeats of the watched gateway, once provisioned */
+void gw_health_start(void);
+/* End of a subscription window, true if the active gateway changed */
+bool gw_health_on_complete(
+		struct gecko_msg_mesh_test_local_heartbeat_subscription_complete_evt_t *evt);
+bool gw_health_is_gateway(uint16 address);
+/* Application traffic from a gateway counts as a sign of life too */
+void gw_health_note_traffic(uint16 address);
+uint16 gw_health_active(void);
+bool gw_health_get(uint8 index, gw_health_info_t *info);
+
+#endif /* GW_HEALTH_H */
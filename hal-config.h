@@ -26,8 +26,13 @@
 #define HAL_VCOM_ENABLE                   (1)
 #endif
 
+/* Size of the retarget serial RX ring used by the command shell */
+#ifndef RXBUFSIZE
+#define RXBUFSIZE                         (128)
+#endif
+
 #ifndef HAL_I2CSENSOR_ENABLE
-#define HAL_I2CSENSOR_ENABLE              (0)
+#define HAL_I2CSENSOR_ENABLE              (1)
 #endif
 
 #ifndef HAL_SPIDISPLAY_ENABLE
@@ -0,0 +1,234 @@
+/***************************************************************************//**
+ * @file
+ * @brief I2C interrupt driven master mode driver with a transfer queue.
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_common.h"
+#include "em_core.h"
+#include "sleep.h"
+#include "i2casync.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup I2CASYNC
+ * @brief I2C interrupt driven master driver
+ *
+ * @details
+ *   Transfers are queued and run one at a time from the I2C interrupt, the
+ *   CPU may sleep in EM1 meanwhile. EM2 is blocked while the queue is not
+ *   empty because the I2C peripheral is not clocked there. Completion
+ *   callbacks are run in order from @ref I2CASYNC_Process(), which the
+ *   application calls from its main loop after @ref I2CASYNC_CompletionHook()
+ *   woke it up.
+ *
+ *   The sequence is copied when queued but the buffers it points to must stay
+ *   valid until the callback. Polled I2CSPM transfers must not be issued
+ *   while @ref I2CASYNC_Busy() returns true.
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+#define I2CASYNC_QUEUE_MASK   (I2CASYNC_QUEUE_SIZE - 1)
+
+typedef struct {
+  I2C_TypeDef                *i2c;
+  I2C_TransferSeq_TypeDef    seq;
+  I2CASYNC_Callback_t        callback;
+  void                       *user;
+  I2C_TransferReturn_TypeDef ret;
+} I2CASYNC_Request_t;
+
+static I2CASYNC_Request_t queue[I2CASYNC_QUEUE_SIZE];
+/* Free running indexes: requests in [deliverIdx, activeIdx) are complete and
+ * wait for their callback, activeIdx is on the bus, [activeIdx, submitIdx)
+ * are pending. */
+static volatile uint8_t submitIdx;
+static volatile uint8_t activeIdx;
+static uint8_t deliverIdx;
+static I2CASYNC_Stats_TypeDef stats;
+
+static IRQn_Type I2CASYNC_IRQn(I2C_TypeDef *i2c)
+{
+#if defined(I2C1)
+  if (i2c == I2C1) {
+    return I2C1_IRQn;
+  }
+#endif
+  (void) i2c;
+  return I2C0_IRQn;
+}
+
+/* Put the next pending request on the bus. Requests that fail to start are
+ * completed immediately. Called from the I2C interrupt or with interrupts
+ * disabled, only while the queue holds a request that is not complete. */
+static void I2CASYNC_StartNext(void)
+{
+  I2CASYNC_Request_t *req;
+  IRQn_Type          irqn;
+  bool               completed = false;
+
+  while (activeIdx != submitIdx) {
+    req  = &queue[activeIdx & I2CASYNC_QUEUE_MASK];
+    irqn = I2CASYNC_IRQn(req->i2c);
+    NVIC_ClearPendingIRQ(irqn);
+    NVIC_EnableIRQ(irqn);
+    req->ret = I2C_TransferInit(req->i2c, &req->seq);
+    if (req->ret == i2cTransferInProgress) {
+      return;
+    }
+    NVIC_DisableIRQ(irqn);
+    activeIdx++;
+    completed = true;
+  }
+
+  SLEEP_SleepBlockEnd(sleepEM2);
+  if (completed) {
+    I2CASYNC_CompletionHook();
+  }
+}
+
+static void I2CASYNC_IRQHandler(void)
+{
+  I2CASYNC_Request_t *req = &queue[activeIdx & I2CASYNC_QUEUE_MASK];
+
+  if (activeIdx == submitIdx) {
+    return;
+  }
+
+  req->ret = I2C_Transfer(req->i2c);
+  if (req->ret == i2cTransferInProgress) {
+    return;
+  }
+
+  /* Keep the interrupt off so polled transfers are not disturbed */
+  NVIC_DisableIRQ(I2CASYNC_IRQn(req->i2c));
+  activeIdx++;
+  I2CASYNC_CompletionHook();
+  I2CASYNC_StartNext();
+}
+
+void I2C0_IRQHandler(void)
+{
+  I2CASYNC_IRQHandler();
+}
+
+#if defined(I2C1)
+void I2C1_IRQHandler(void)
+{
+  I2CASYNC_IRQHandler();
+}
+#endif
+
+/** @endcond */
+
+/***************************************************************************//**
+ * @brief
+ *   Queue an I2C transfer.
+ *
+ * @param[in] i2c
+ *   Pointer to I2C peripheral register block, initialized by I2CSPM_Init().
+ *
+ * @param[in] seq
+ *   Transfer sequence, copied into the queue.
+ *
+ * @param[in] callback
+ *   Called from @ref I2CASYNC_Process() with the transfer result, may be NULL.
+ *
+ * @param[in] user
+ *   Passed to the callback.
+ *
+ * @return
+ *   true if queued, false if the queue is full.
+ ******************************************************************************/
+bool I2CASYNC_Transfer(I2C_TypeDef *i2c,
+                       const I2C_TransferSeq_TypeDef *seq,
+                       I2CASYNC_Callback_t callback,
+                       void *user)
+{
+  CORE_DECLARE_IRQ_STATE;
+  I2CASYNC_Request_t *req;
+  bool               idle;
+
+  if ((uint8_t) (submitIdx - deliverIdx) >= I2CASYNC_QUEUE_SIZE) {
+    stats.rejected++;
+    return false;
+  }
+
+  req           = &queue[submitIdx & I2CASYNC_QUEUE_MASK];
+  req->i2c      = i2c;
+  req->seq      = *seq;
+  req->callback = callback;
+  req->user     = user;
+  req->ret      = i2cTransferInProgress;
+
+  CORE_ENTER_ATOMIC();
+  idle = (activeIdx == submitIdx);
+  submitIdx++;
+  if (idle) {
+    SLEEP_SleepBlockBegin(sleepEM2);
+    I2CASYNC_StartNext();
+  }
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Run the callbacks of completed transfers, in submission order.
+ *
+ * @details
+ *   Callbacks may queue new transfers.
+ ******************************************************************************/
+void I2CASYNC_Process(void)
+{
+  I2CASYNC_Request_t *req;
+
+  while (deliverIdx != activeIdx) {
+    req = &queue[deliverIdx & I2CASYNC_QUEUE_MASK];
+    if (req->ret == i2cTransferDone) {
+      stats.done++;
+    } else {
+      stats.failed++;
+    }
+    if (req->callback != NULL) {
+      req->callback(req->ret, req->user);
+    }
+    deliverIdx++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether a transfer is on the bus or pending.
+ ******************************************************************************/
+bool I2CASYNC_Busy(void)
+{
+  return activeIdx != submitIdx;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copy the transfer statistics.
+ ******************************************************************************/
+void I2CASYNC_GetStats(I2CASYNC_Stats_TypeDef *out)
+{
+  *out = stats;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Default completion hook, does nothing.
+ ******************************************************************************/
+SL_WEAK void I2CASYNC_CompletionHook(void)
+{
+}
+
+/** @} (end group I2CASYNC) */
+/** @} (end group kitdrv) */
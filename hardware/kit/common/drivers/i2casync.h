@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief I2C interrupt driven master mode driver with a transfer queue.
+ ******************************************************************************/
+
+#ifndef __I2CASYNC_H__
+#define __I2CASYNC_H__
+
+#include <stdbool.h>
+#include "em_i2c.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup I2CASYNC
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** Number of queued transfers, must be a power of two */
+#if !defined(I2CASYNC_QUEUE_SIZE)
+#define I2CASYNC_QUEUE_SIZE   4
+#endif
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Completion callback, called from @ref I2CASYNC_Process() */
+typedef void (*I2CASYNC_Callback_t)(I2C_TransferReturn_TypeDef ret,
+                                    void *user);
+
+/** Transfer statistics */
+typedef struct {
+  uint32_t done;      /**< Transfers completed with i2cTransferDone */
+  uint32_t failed;    /**< Transfers completed with an error */
+  uint32_t rejected;  /**< Submissions refused because the queue was full */
+} I2CASYNC_Stats_TypeDef;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+bool I2CASYNC_Transfer(I2C_TypeDef *i2c,
+                       const I2C_TransferSeq_TypeDef *seq,
+                       I2CASYNC_Callback_t callback,
+                       void *user);
+void I2CASYNC_Process(void);
+bool I2CASYNC_Busy(void);
+void I2CASYNC_GetStats(I2CASYNC_Stats_TypeDef *stats);
+
+/* Called from interrupt context when a transfer completed, override it to
+ * wake the main loop so that it calls I2CASYNC_Process() */
+void I2CASYNC_CompletionHook(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group I2CASYNC) */
+/** @} (end group kitdrv) */
+
+#endif /* __I2CASYNC_H__ */
@@ -20,6 +20,7 @@
 #include "em_cmu.h"
 #include "em_core.h"
 #include "em_gpio.h"
+#include "em_common.h"
 #include "retargetserial.h"
 
 #if defined(HAL_CONFIG)
@@ -57,6 +58,16 @@ static volatile uint8_t rxBuffer[RXBUFSIZE]; /**< Buffer to store data */
 static uint8_t LFtoCRLF = 0; /**< LF to CRLF conversion disabled */
 static bool initialized = false; /**< Initialize UART/LEUART */
 
+/**************************************************************************//**
+ * @brief Called from the RX interrupt after a byte has been buffered.
+ * @param c The received byte
+ * @note Default implementation does nothing, override to get notified of
+ *       incoming data without polling RETARGET_ReadChar().
+ *****************************************************************************/
+SL_WEAK void RETARGET_SerialRxHook(int c) {
+	(void) c;
+}
+
 /**************************************************************************//**
  * @brief Disable RX interrupt
  *****************************************************************************/
@@ -91,12 +102,14 @@ void RETARGET_IRQ_NAME(void) {
 
 		if (rxCount < RXBUFSIZE) {
 			/* There is room for data in the RX buffer so we store the data. */
-			rxBuffer[rxWriteIndex] = RETARGET_RX(RETARGET_UART);
+			uint8_t c = RETARGET_RX(RETARGET_UART);
+			rxBuffer[rxWriteIndex] = c;
 			rxWriteIndex++;
 			rxCount++;
 			if (rxWriteIndex == RXBUFSIZE) {
 				rxWriteIndex = 0;
 			}
+			RETARGET_SerialRxHook(c);
 		} else {
 			/* The RX buffer is full so we must wait for the RETARGET_ReadChar()
 			 * function to make some more room in the buffer. RX interrupts are
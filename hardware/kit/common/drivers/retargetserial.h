@@ -55,6 +55,7 @@ void RETARGET_SerialCrLf(int on);
 void RETARGET_SerialInit(void);
 bool RETARGET_SerialEnableFlowControl(void);
 void RETARGET_SerialFlush(void);
+void RETARGET_SerialRxHook(int c);
 
 #ifdef __cplusplus
 }
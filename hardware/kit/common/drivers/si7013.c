@@ -18,6 +18,7 @@
 #include <stddef.h>
 #include "si7013.h"
 #include "i2cspm.h"
+#include "i2casync.h"
 
 #include "stddef.h"
 
@@ -422,5 +423,158 @@ bool Si7013_Detect(I2C_TypeDef *i2c, uint8_t addr, uint8_t *deviceId)
   return true;
 }
 
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+typedef enum {
+  si7013AsyncIdle,
+  si7013AsyncStart,
+  si7013AsyncReadRH,
+  si7013AsyncReadTemp
+} Si7013_AsyncPhase_t;
+
+/* A single asynchronous operation may be outstanding, the buffers live here
+ * until the I2C transfer completed. */
+static struct {
+  Si7013_AsyncPhase_t phase;
+  I2C_TypeDef         *i2c;
+  uint8_t             addr;
+  Si7013_Callback_t   callback;
+  void                *user;
+  uint8_t             writeData[1];
+  uint8_t             readData[2];
+  uint32_t            rhData;
+} si7013Async;
+
+static void Si7013_AsyncDone(I2C_TransferReturn_TypeDef ret, void *user);
+
+static bool Si7013_AsyncSubmit(Si7013_AsyncPhase_t phase, uint16_t flags,
+                               uint16_t writeLen, uint16_t readLen)
+{
+  I2C_TransferSeq_TypeDef seq;
+
+  seq.addr        = si7013Async.addr;
+  seq.flags       = flags;
+  seq.buf[0].data = (flags == I2C_FLAG_READ) ? si7013Async.readData
+                    : si7013Async.writeData;
+  seq.buf[0].len  = (flags == I2C_FLAG_READ) ? readLen : writeLen;
+  seq.buf[1].data = si7013Async.readData;
+  seq.buf[1].len  = readLen;
+
+  si7013Async.phase = phase;
+  if (!I2CASYNC_Transfer(si7013Async.i2c, &seq, Si7013_AsyncDone, NULL)) {
+    si7013Async.phase = si7013AsyncIdle;
+    return false;
+  }
+  return true;
+}
+
+static void Si7013_AsyncFinish(int32_t ret, uint32_t rhData, int32_t tData)
+{
+  si7013Async.phase = si7013AsyncIdle;
+  si7013Async.callback(ret, rhData, tData, si7013Async.user);
+}
+
+static void Si7013_AsyncDone(I2C_TransferReturn_TypeDef ret, void *user)
+{
+  uint32_t data;
+
+  (void) user;
+  if (ret != i2cTransferDone) {
+    Si7013_AsyncFinish((int32_t) ret, 0, 0);
+    return;
+  }
+
+  data = ((uint32_t) si7013Async.readData[0] << 8)
+         + (si7013Async.readData[1] & 0xfc);
+
+  switch (si7013Async.phase) {
+    case si7013AsyncReadRH:
+      /* convert to milli-percent */
+      si7013Async.rhData       = ((data * 15625L) >> 13) - 6000;
+      si7013Async.writeData[0] = SI7013_READ_TEMP;
+      if (!Si7013_AsyncSubmit(si7013AsyncReadTemp, I2C_FLAG_WRITE_READ, 1, 2)) {
+        Si7013_AsyncFinish(-1, 0, 0);
+      }
+      break;
+
+    case si7013AsyncReadTemp:
+      /* convert to milli-degC */
+      Si7013_AsyncFinish(0, si7013Async.rhData,
+                         (((int32_t) data * 21965L) >> 13) - 46850);
+      break;
+
+    default:
+      Si7013_AsyncFinish(0, 0, 0);
+      break;
+  }
+}
+
+static int32_t Si7013_AsyncBegin(I2C_TypeDef *i2c, uint8_t addr,
+                                 Si7013_Callback_t callback, void *user)
+{
+  if (si7013Async.phase != si7013AsyncIdle || callback == NULL) {
+    return -1;
+  }
+  si7013Async.i2c      = i2c;
+  si7013Async.addr     = addr;
+  si7013Async.callback = callback;
+  si7013Async.user     = user;
+  return 0;
+}
+/** @endcond */
+
+/**************************************************************************//**
+ * @brief
+ *  Starts no hold measurement of relative humidity and temperature without
+ *  waiting for the I2C transfer.
+ * @param[in] i2c
+ *   The I2C peripheral to use.
+ * @param[in] addr
+ *   The I2C address of the sensor.
+ * @param[in] callback
+ *   Called from I2CASYNC_Process() when the command was sent, with zero on
+ *   OK. The measurement values passed are zero.
+ * @param[in] user
+ *   Passed to the callback.
+ * @return
+ *   Returns zero if the command was queued, non-zero otherwise.
+ *****************************************************************************/
+int32_t Si7013_StartNoHoldMeasureRHAndTempAsync(I2C_TypeDef *i2c, uint8_t addr,
+                                                Si7013_Callback_t callback,
+                                                void *user)
+{
+  if (Si7013_AsyncBegin(i2c, addr, callback, user)) {
+    return -1;
+  }
+  si7013Async.writeData[0] = SI7013_READ_RH_NH;
+  return Si7013_AsyncSubmit(si7013AsyncStart, I2C_FLAG_WRITE, 1, 0) ? 0 : -1;
+}
+
+/**************************************************************************//**
+ * @brief
+ *  Reads relative humidity and temperature of a no hold measurement without
+ *  waiting for the I2C transfers.
+ * @param[in] i2c
+ *   The I2C peripheral to use.
+ * @param[in] addr
+ *   The I2C address of the sensor.
+ * @param[in] callback
+ *   Called from I2CASYNC_Process() with zero on OK, the relative humidity in
+ *   percent (multiplied by 1000) and the temperature in milli-Celsius. The
+ *   sensor NACKs the read while the conversion is still running.
+ * @param[in] user
+ *   Passed to the callback.
+ * @return
+ *   Returns zero if the read was queued, non-zero otherwise.
+ *****************************************************************************/
+int32_t Si7013_ReadNoHoldRHAndTempAsync(I2C_TypeDef *i2c, uint8_t addr,
+                                        Si7013_Callback_t callback,
+                                        void *user)
+{
+  if (Si7013_AsyncBegin(i2c, addr, callback, user)) {
+    return -1;
+  }
+  return Si7013_AsyncSubmit(si7013AsyncReadRH, I2C_FLAG_READ, 0, 2) ? 0 : -1;
+}
+
 /** @} (end group Si7013) */
 /** @} (end group kitdrv) */
@@ -51,6 +51,14 @@ extern "C" {
 /** Device ID value for Si7021 */
 #define SI7021_DEVICE_ID 0x21
 
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Completion callback of the asynchronous functions */
+typedef void (*Si7013_Callback_t)(int32_t ret, uint32_t rhData, int32_t tData,
+                                  void *user);
+
 /*******************************************************************************
  *****************************   PROTOTYPES   **********************************
  ******************************************************************************/
@@ -65,6 +73,12 @@ int32_t Si7013_ReadNoHoldRHAndTemp(I2C_TypeDef *i2c, uint8_t addr, uint32_t *rhD
                                    int32_t *tData);
 int32_t Si7013_StartNoHoldMeasureRHAndTemp(I2C_TypeDef *i2c, uint8_t addr);
 int32_t Si7013_MeasureV(I2C_TypeDef *i2c, uint8_t addr, int32_t *vData);
+int32_t Si7013_StartNoHoldMeasureRHAndTempAsync(I2C_TypeDef *i2c, uint8_t addr,
+                                                Si7013_Callback_t callback,
+                                                void *user);
+int32_t Si7013_ReadNoHoldRHAndTempAsync(I2C_TypeDef *i2c, uint8_t addr,
+                                        Si7013_Callback_t callback,
+                                        void *user);
 #ifdef __cplusplus
 }
 #endif
@@ -15,7 +15,9 @@
  *
  ******************************************************************************/
 
+#include <stddef.h>
 #include "i2cspm.h"
+#include "i2casync.h"
 #include "tempsens.h"
 
 /***************************************************************************//**
@@ -176,6 +178,25 @@ int TEMPSENS_RegisterSet(I2C_TypeDef *i2c,
   return(ret);
 }
 
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+/* Convert the temperature register value to Celsius */
+static void TEMPSENS_Convert(uint16_t val, TEMPSENS_Temp_TypeDef *temp)
+{
+  /* Get all 12 bits potentially used */
+  uint32_t tmp = (uint32_t)(val >> 4);
+
+  /* If negative number, convert using 2s complement */
+  if (tmp & 0x800) {
+    tmp     = (~tmp + 1) & 0xfff;
+    temp->i = -(int16_t)(tmp >> 4);
+    temp->f = -(int16_t)((tmp & 0xf) * 625);
+  } else {
+    temp->i = (int16_t)(tmp >> 4);
+    temp->f = (int16_t)((tmp & 0xf) * 625);
+  }
+}
+/** @endcond */
+
 /***************************************************************************//**
  * @brief
  *   Fetch current temperature from temperature sensor (in Celsius).
@@ -212,7 +233,6 @@ int TEMPSENS_TemperatureGet(I2C_TypeDef *i2c,
                             TEMPSENS_Temp_TypeDef *temp)
 {
   int      ret;
-  uint32_t tmp;
   uint16_t val = 0;
 
   ret = TEMPSENS_RegisterGet(i2c, addr, tempsensRegTemp, &val);
@@ -220,18 +240,84 @@ int TEMPSENS_TemperatureGet(I2C_TypeDef *i2c,
     return(ret);
   }
 
-  /* Get all 12 bits potentially used */
-  tmp = (uint32_t)(val >> 4);
+  TEMPSENS_Convert(val, temp);
 
-  /* If negative number, convert using 2s complement */
-  if (tmp & 0x800) {
-    tmp     = (~tmp + 1) & 0xfff;
-    temp->i = -(int16_t)(tmp >> 4);
-    temp->f = -(int16_t)((tmp & 0xf) * 625);
-  } else {
-    temp->i = (int16_t)(tmp >> 4);
-    temp->f = (int16_t)((tmp & 0xf) * 625);
+  return(0);
+}
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+/* Buffers of the outstanding asynchronous read, valid until it completed */
+static struct {
+  bool                 busy;
+  TEMPSENS_Callback_t  callback;
+  void                 *user;
+  uint8_t              regid[1];
+  uint8_t              data[2];
+} tempsensAsync;
+
+static void TEMPSENS_AsyncDone(I2C_TransferReturn_TypeDef ret, void *user)
+{
+  TEMPSENS_Temp_TypeDef temp = { 0, 0 };
+
+  (void) user;
+  tempsensAsync.busy = false;
+  if (ret == i2cTransferDone) {
+    TEMPSENS_Convert((((uint16_t)(tempsensAsync.data[0])) << 8)
+                     | tempsensAsync.data[1], &temp);
+  }
+  tempsensAsync.callback((ret == i2cTransferDone) ? 0 : (int) ret, &temp,
+                         tempsensAsync.user);
+}
+/** @endcond */
+
+/***************************************************************************//**
+ * @brief
+ *   Fetch current temperature from temperature sensor without waiting for the
+ *   I2C transfer.
+ *
+ * @param[in] i2c
+ *   Pointer to I2C peripheral register block.
+ *
+ * @param[in] addr
+ *   I2C address for temperature sensor, in 8 bit format, where LSB is reserved
+ *   for R/W bit.
+ *
+ * @param[in] callback
+ *   Called from I2CASYNC_Process() with 0 and the temperature (in Celsius) if
+ *   read, <0 if unable to read temperature.
+ *
+ * @param[in] user
+ *   Passed to the callback.
+ *
+ * @return
+ *   Returns 0 if the read was queued, <0 if a read is already outstanding or
+ *   the I2C queue is full.
+ ******************************************************************************/
+int TEMPSENS_TemperatureGetAsync(I2C_TypeDef *i2c,
+                                 uint8_t addr,
+                                 TEMPSENS_Callback_t callback,
+                                 void *user)
+{
+  I2C_TransferSeq_TypeDef seq;
+
+  if (tempsensAsync.busy || callback == NULL) {
+    return(-1);
+  }
+
+  seq.addr  = addr;
+  seq.flags = I2C_FLAG_WRITE_READ;
+  tempsensAsync.regid[0] = ((uint8_t) tempsensRegTemp) & 0x3;
+  seq.buf[0].data        = tempsensAsync.regid;
+  seq.buf[0].len         = 1;
+  seq.buf[1].data        = tempsensAsync.data;
+  seq.buf[1].len         = 2;
+
+  if (!I2CASYNC_Transfer(i2c, &seq, TEMPSENS_AsyncDone, NULL)) {
+    return(-1);
   }
+  tempsensAsync.busy     = true;
+  tempsensAsync.callback = callback;
+  tempsensAsync.user     = user;
 
   return(0);
 }
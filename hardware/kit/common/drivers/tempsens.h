@@ -69,6 +69,10 @@ typedef struct {
   int16_t f;
 } TEMPSENS_Temp_TypeDef;
 
+/** Completion callback of @ref TEMPSENS_TemperatureGetAsync() */
+typedef void (*TEMPSENS_Callback_t)(int ret, TEMPSENS_Temp_TypeDef *temp,
+                                    void *user);
+
 /*******************************************************************************
  *****************************   PROTOTYPES   **********************************
  ******************************************************************************/
@@ -85,6 +89,10 @@ int TEMPSENS_RegisterSet(I2C_TypeDef *i2c,
 int TEMPSENS_TemperatureGet(I2C_TypeDef *i2c,
                             uint8_t addr,
                             TEMPSENS_Temp_TypeDef *temp);
+int TEMPSENS_TemperatureGetAsync(I2C_TypeDef *i2c,
+                                 uint8_t addr,
+                                 TEMPSENS_Callback_t callback,
+                                 void *user);
 
 #ifdef __cplusplus
 }
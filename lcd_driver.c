@@ -20,6 +20,8 @@
 #include <string.h>
 #include "graphics.h"
 #include "lcd_driver.h"
+#include "prof.h"
+#include "work_queue.h"
 
 #if (HAL_SPIDISPLAY_ENABLE == 1)
 
@@ -56,6 +58,27 @@ void LCD_init(char* str) {
   graphInit(header);
 }
 
+/*
+ * Redraws every row. Posted as deferred work by LCD_write(), the SPI
+ * transfer of a full frame is too long for an event handler.
+*/
+static void LCD_flush(uint32 arg) {
+  int i;
+  char *pRow;
+  char LCD_message[LCD_ROW_MAX * LCD_ROW_LEN];
+  PROF_SCOPE(PROF_LCD_FLUSH);
+
+  LCD_message[0] = 0;
+
+  for (i = 0; i < LCD_ROW_MAX; i++) {
+    pRow  = &(LCD_data[i][0]);
+    strcat(LCD_message, pRow);
+    strcat(LCD_message, "\n"); // add newline at end of reach row
+  }
+
+  graphWriteString(LCD_message);
+}
+
 /*
  * This function is used to write one line in the LCD.
  * The parameter 'row' selects which line is written,
@@ -64,7 +87,6 @@ void LCD_init(char* str) {
 void LCD_write(char *str, uint8 row) {
   int i = 0;
   char *pRow;
-  char LCD_message[LCD_ROW_MAX * LCD_ROW_LEN];
 
   char new_str[ROW_LINE * LCD_ROW_LEN];
 
@@ -81,14 +103,7 @@ void LCD_write(char *str, uint8 row) {
 
   snprintf(pRow, i + 1, new_str);
 
-  LCD_message[0] = 0;
-
-  for (i = 0; i < LCD_ROW_MAX; i++) {
-    pRow  = &(LCD_data[i][0]);
-    strcat(LCD_message, pRow);
-    strcat(LCD_message, "\n"); // add newline at end of reach row
-  }
-
-  graphWriteString(LCD_message);
+  //Writes until the flush runs share one redraw
+  work_queue_post(WORK_PRIO_LOW, LCD_flush, 0);
 }
 #endif /* HAL_SPIDISPLAY_ENABLE */
@@ -0,0 +1,192 @@
+/***************************************************************************//**
+ * @file
+ * @brief lpn_table.c
+ * Questions over all LPNs (any alarm, which are dead, what changed) are a
+ * mask of one word; only the time out sweep walks the byte array.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "app_time.h"
+#include "lpn_table.h"
+
+lpn_table_t lpn_table;
+
+static uint32 used_mask(void) {
+	return lpn_table.count >= 32 ? 0xffffffff : LPN_BIT(lpn_table.count) - 1;
+}
+
+/* Bit to takes the value of bit from */
+static uint32 move_bit(uint32 set, uint8 to, uint8 from) {
+	set &= ~LPN_BIT(to);
+	return set | (((set >> from) & 1) << to);
+}
+
+void lpn_table_init(void) {
+	memset(&lpn_table, 0, sizeof(lpn_table));
+}
+
+uint8 lpn_table_find(uint8 address) {
+	uint8 i;
+
+	for (i = 0; i < lpn_table.count; i++) {
+		if (lpn_table.address[i] == address) {
+			return i;
+		}
+	}
+	return LPN_TABLE_NONE;
+}
+
+uint8 lpn_table_add(uint8 address) {
+	uint8 i = lpn_table.count;
+
+	if (i >= LPN_TABLE_MAX) {
+		return LPN_TABLE_NONE;
+	}
+	lpn_table.address[i] = address & 0x7f;
+	lpn_table.battery[i] = 0;
+	lpn_table.time_out[i] = 0;
+	lpn_table.stamp_ms[i] = app_time_ms();
+	lpn_table.alarm &= ~LPN_BIT(i);
+	lpn_table.alive &= ~LPN_BIT(i);
+	lpn_table.expired &= ~LPN_BIT(i);
+	lpn_table.unheard |= LPN_BIT(i);
+	lpn_table.dirty |= LPN_BIT(i);
+	lpn_table.provisional &= ~LPN_BIT(i);
+	lpn_table.count++;
+	return i;
+}
+
+bool lpn_table_update(uint8 index, uint16 message) {
+	uint32 bit = LPN_BIT(index);
+	bool changed = lpn_table_message(index) != message;
+
+	lpn_table.alarm = (lpn_table.alarm & ~bit) | ((message & 0x01) ? bit : 0);
+	lpn_table.alive = (lpn_table.alive & ~bit)
+			| ((message & 0x0100) ? bit : 0);
+	lpn_table.expired &= ~bit;
+	lpn_table.unheard &= ~bit;
+	lpn_table.battery[index] = (message >> 9) & 0x7f;
+	lpn_table.time_out[index] = 0;
+	lpn_table.stamp_ms[index] = app_time_ms();
+	if (changed) {
+		lpn_table.dirty |= bit;
+	}
+	return changed;
+}
+
+void lpn_table_remove(uint8 index) {
+	uint8 last;
+
+	if (index >= lpn_table.count) {
+		return;
+	}
+	last = --lpn_table.count;
+	lpn_table.address[index] = lpn_table.address[last];
+	lpn_table.battery[index] = lpn_table.battery[last];
+	lpn_table.time_out[index] = lpn_table.time_out[last];
+	lpn_table.stamp_ms[index] = lpn_table.stamp_ms[last];
+	lpn_table.alarm = move_bit(lpn_table.alarm, index, last) & used_mask();
+	lpn_table.alive = move_bit(lpn_table.alive, index, last) & used_mask();
+	lpn_table.dirty = move_bit(lpn_table.dirty, index, last) & used_mask();
+	lpn_table.expired = move_bit(lpn_table.expired, index, last) & used_mask();
+	lpn_table.unheard = move_bit(lpn_table.unheard, index, last) & used_mask();
+	lpn_table.provisional = move_bit(lpn_table.provisional, index, last)
+			& used_mask();
+}
+
+void lpn_table_restore(uint8 index, uint16 message, uint8 time_out) {
+	lpn_table_update(index, message);
+	lpn_table.time_out[index] = time_out;
+	lpn_table.stamp_ms[index] = app_time_ms() - LPN_TABLE_STALE_MS;
+	lpn_table.provisional |= LPN_BIT(index);
+}
+
+void lpn_table_confirm(uint8 index) {
+	lpn_table.provisional &= ~LPN_BIT(index);
+}
+
+uint8 lpn_table_drop_provisional(void) {
+	uint8 dropped = 0;
+	uint8 i;
+
+	//Backwards, so the entry moved into a freed slot was already checked
+	for (i = lpn_table.count; i-- > 0;) {
+		if (lpn_table.provisional & LPN_BIT(i)) {
+			lpn_table_remove(i);
+			dropped++;
+		}
+	}
+	return dropped;
+}
+
+uint16 lpn_table_message(uint8 index) {
+	return ((lpn_table.alarm >> index) & 1)
+			| ((lpn_table.address[index] & 0x7f) << 1)
+			| (((lpn_table.alive >> index) & 1) << 8)
+			| ((lpn_table.battery[index] & 0x7f) << 9);
+}
+
+uint32 lpn_table_sweep(uint8 max_time_out) {
+	uint32 expired = 0;
+	uint32 lost;
+	uint8 i;
+
+	for (i = 0; i < lpn_table.count; i++) {
+		if (lpn_table.time_out[i] != 0xff) {
+			lpn_table.time_out[i]++;
+		}
+		if (lpn_table.time_out[i] > max_time_out) {
+			expired |= LPN_BIT(i);
+		}
+	}
+	lpn_table.expired = expired;
+	lost = lpn_table.alive & expired;
+	lpn_table.alive &= ~expired;
+	lpn_table.dirty |= lost;
+	return lost;
+}
+
+uint8 lpn_table_quietest(void) {
+	uint8 quietest = 0;
+	uint8 i;
+
+	if (lpn_table.count == 0) {
+		return LPN_TABLE_NONE;
+	}
+	for (i = 1; i < lpn_table.count; i++) {
+		if (lpn_table.time_out[i] > lpn_table.time_out[quietest]
+				|| (lpn_table.time_out[i] == lpn_table.time_out[quietest]
+						&& (lpn_table.unheard & LPN_BIT(i))
+						&& !(lpn_table.unheard & LPN_BIT(quietest)))) {
+			quietest = i;
+		}
+	}
+	return quietest;
+}
+
+uint8 lpn_table_evictable(void) {
+	uint32 candidates = (lpn_table.provisional | lpn_table.expired)
+			& used_mask();
+	uint8 evictable = LPN_TABLE_NONE;
+	uint8 i;
+
+	for (i = 0; i < lpn_table.count; i++) {
+		if ((candidates & LPN_BIT(i)) && (evictable == LPN_TABLE_NONE
+				|| lpn_table.time_out[i] > lpn_table.time_out[evictable])) {
+			evictable = i;
+		}
+	}
+	return evictable;
+}
+
+uint32 lpn_table_dead(void) {
+	return lpn_table.expired & used_mask();
+}
+
+uint32 lpn_table_take_dirty(void) {
+	uint32 dirty = lpn_table.dirty & used_mask();
+
+	lpn_table.dirty = 0;
+	return dirty;
+}
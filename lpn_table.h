@@ -0,0 +1,78 @@
+/***************************************************************************//**
+ * @file
+ * @brief lpn_table.h
+ * State of the friend LPNs as parallel arrays, flags as one bit per LPN.
+ ******************************************************************************/
+
+#ifndef LPN_TABLE_H
+#define LPN_TABLE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "mesh_app_memory_config.h"
+
+#define LPN_TABLE_MAX		MESH_CFG_MAX_FRIENDSHIPS
+#define LPN_TABLE_NONE		0xff
+
+#if LPN_TABLE_MAX > 32
+#error "LPN flags are 32 bit sets"
+#endif
+
+#define LPN_BIT(index)		(1UL << (index))
+/* Stamp offset of a record whose last message is from before a reset, far
+ * enough back for any age derived from it to saturate */
+#define LPN_TABLE_STALE_MS	0x80000000UL
+
+/* Bit i of a set belongs to entry i, entries 0..count-1 are in use. Records
+ * keep the level message layout: bit 0 alarm, bits 1..7 address, bit 8
+ * heartbeat, bits 9..15 battery. */
+typedef struct {
+	uint32 alarm;		/* last message carried the alarm bit */
+	uint32 alive;		/* heartbeat bit, cleared when the LPN times out */
+	uint32 expired;		/* silent past the time out of the last sweep */
+	uint32 unheard;		/* no message since the entry was added */
+	uint32 dirty;		/* record changed since lpn_table_take_dirty() */
+	uint32 provisional;	/* restored, friendship not re-established yet */
+	uint8 count;
+	uint8 address[LPN_TABLE_MAX];	/* 7 bit unicast address */
+	uint8 battery[LPN_TABLE_MAX];	/* 7 bit percent */
+	uint8 time_out[LPN_TABLE_MAX];	/* sweep periods since the last message */
+	uint32 stamp_ms[LPN_TABLE_MAX];	/* app_time_ms() of the last message */
+} lpn_table_t;
+
+extern lpn_table_t lpn_table;
+
+void lpn_table_init(void);
+uint8 lpn_table_find(uint8 address);
+/* Index of a new entry for address, LPN_TABLE_NONE when full */
+uint8 lpn_table_add(uint8 address);
+/* Take a level message from the LPN, restarts its time out. True if the
+ * record differs from the previous one. */
+bool lpn_table_update(uint8 index, uint16 message);
+/* The last entry moves into the slot */
+void lpn_table_remove(uint8 index);
+/* Entry taken from a snapshot: provisional, and its record is not fresh */
+void lpn_table_restore(uint8 index, uint16 message, uint8 time_out);
+/* The LPN made friends again, the entry is no longer provisional */
+void lpn_table_confirm(uint8 index);
+/* Remove the provisional entries, returns how many there were */
+uint8 lpn_table_drop_provisional(void);
+/* Provisional or dead entry silent for the most periods, the one to give up
+ * for a new friendship. LPN_TABLE_NONE if every entry is a friend still
+ * within its time out. */
+uint8 lpn_table_evictable(void);
+uint16 lpn_table_message(uint8 index);
+/* Count a sweep period: LPNs silent for more than max_time_out periods lose
+ * their heartbeat and are marked dirty. Returns the entries that lost it in
+ * this sweep. */
+uint32 lpn_table_sweep(uint8 max_time_out);
+/* Entry silent for the most periods, one never heard from on a tie.
+ * LPN_TABLE_NONE if empty. */
+uint8 lpn_table_quietest(void);
+/* Entries the sweep found silent past the time out. A new entry is not dead
+ * before it had the time out to speak. */
+uint32 lpn_table_dead(void);
+/* Entries changed since the last call, and clears them */
+uint32 lpn_table_take_dirty(void);
+
+#endif /* LPN_TABLE_H */
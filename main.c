@@ -58,6 +58,31 @@
 #include "graphics.h"
 #include "lcd_driver.h"
 #include "mesh_data.h"
+#include "lpn_table.h"
+#include "receive_node.h"
+#include "serial_shell.h"
+#include "dedup_cache.h"
+#include "send_queue.h"
+#include "report_sched.h"
+#include "node_stats.h"
+#include "env_sensor.h"
+#include "i2casync.h"
+#include "buttons.h"
+#include "report_auth.h"
+#include "node_store.h"
+#include "vendor_data.h"
+#include "conn_policy.h"
+#include "event_trace.h"
+#include "prof.h"
+#include "stack_mon.h"
+#include "alarm_coalesce.h"
+#include "gw_health.h"
+#include "node_hb.h"
+#include "time_sync.h"
+#include "app_time.h"
+#include "app_timer.h"
+#include "event_dispatch.h"
+#include "work_queue.h"
 /***********************************************************************************************//**
  * Define for Led
  *
@@ -127,7 +152,6 @@ MAX_CONNECTIONS, .bluetooth.max_advertisers = MAX_ADVERTISERS, .bluetooth.heap =
  */
 #define MY_APP_HEADER 		"\nFIRMESH TEAM\nBLE MESH THESIS\n******************\n"
 #define MY_APP_HEADER_SIZE 	(sizeof(MY_APP_HEADER))
-#define APP_KEY_INDEX	0
 //Define clock frequency
 #define TIMER_CLOCK_FREQ             (uint32) 32768
 #define TIMER_MILLIS_SECONDS(ms)     ((TIMER_CLOCK_FREQ * ms)/1000)
@@ -143,17 +167,23 @@ MAX_CONNECTIONS, .bluetooth.max_advertisers = MAX_ADVERTISERS, .bluetooth.heap =
  #define TIMER_ID_CHECK_GATEWAY_HEAT_BEAT 80*/
 #define TIMER_ID_CHECK_HEALTH		79
 #define TIMER_ID_SEND_MESSAGE  81
-/* Define Response flag when send Mesh data */
-#define FLAG_NON_RESPONSE          0x00
-#define FLAG_RESPONSE              0x01
+#define TIMER_ID_LPN_SWEEP		94
+//External signal of the I2C interrupt, SHELL_EXT_SIGNAL uses 0x01
+#define I2C_EXT_SIGNAL			0x00000002
 /*Define led state*/
 #define LED_STATE_OFF    		0
 #define LED_STATE_ON 			1
-/* Define Retransmit flag */
-#define FLAG_RETRANS               0x01
-#define FLAG_NON_RETRANS           0x00
 
+/* LPN liveness is swept at a fixed period, the report interval adapts to the
+ * load and would make the time out anything from seconds to hours */
+#define LPN_SWEEP_PERIOD_S		REPORT_INTERVAL_DEFAULT
+//Sweep periods an LPN may stay silent before it loses its heartbeat
 #define MAX_TIME_OUT 			3
+//Sweep periods a restored LPN has to make friends again before it is dropped
+#define PROVISIONAL_TIME_OUT	(2 * MAX_TIME_OUT)
+
+//Pages shown on the sensor rows, cycled with button 1
+#define DISPLAY_PAGES			3
 //Global Variable
 ///Number of active Bluetooth connections
 static uint8 num_connections = 0;
@@ -164,35 +194,32 @@ static uint8 connection_handle = 0xFF;
 static uint16 this_node_address;
 static uint16 primary_element = 0;
 static uint16 transaction_id = 0;
-static uint16 gateway_address = 1;
-
-mesh_lpn_data_array_t mesh_lpn_data_array;
-
-static uint16 gateway_time_out;
+static uint16 gateway_address = GW_HEALTH_PRIMARY;
 
 static uint8 index = 0;
 static uint8 num_lpn = 0;
+//Sweep periods since the snapshot was restored, while entries are provisional
+static uint8 provisional_periods = 0;
+
+/* Period of TIMER_ID_CHECK_HEALTH, adjustable from the serial shell */
+static uint16 report_interval = REPORT_INTERVAL_DEFAULT;
+static bool health_timer_started = false;
+static uint8 display_page = 0;
 
 //User function
 static void button_init();
 static void led_init();
 void set_device_name(bd_addr *pAddr);
 void factory_reset();
-void receive_node_init();
 
-static void pri_level_request(uint16_t model_id, uint16_t element_index,
-		uint16_t client_addr, uint16_t server_addr, uint16_t appkey_index,
-		const struct mesh_generic_request *request, uint32_t transition_ms,
-		uint16_t delay_ms, uint8_t request_flags);
-
-static void pri_level_change(uint16_t model_id, uint16_t element_index,
-		const struct mesh_generic_state *current,
-		const struct mesh_generic_state *target, uint32_t remaining_ms);
+static void pri_level_request(const struct mesh_lib_request_view *view);
 
 static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt);
+static void register_handlers(void);
 bool mesh_bgapi_listener(struct gecko_cmd_packet *evt);
 void mesh_data_init();
 int main() {
+	stack_mon_paint();
 	// Initialize device
 	initMcu();
 	// Initialize board
@@ -224,17 +251,20 @@ int main() {
 	//gecko_bgapi_class_mesh_proxy_client_init();
 	gecko_bgapi_class_mesh_generic_client_init();
 	gecko_bgapi_class_mesh_generic_server_init();
-	//gecko_bgapi_class_mesh_vendor_model_init();
+	gecko_bgapi_class_mesh_sensor_server_init();
+	gecko_bgapi_class_mesh_vendor_model_init();
 	//gecko_bgapi_class_mesh_health_client_init();
 	//gecko_bgapi_class_mesh_health_server_init();
-	//gecko_bgapi_class_mesh_test_init();
+	gecko_bgapi_class_mesh_test_init();
 	//gecko_bgapi_class_mesh_lpn_init();
 	gecko_bgapi_class_mesh_friend_init();
+	gecko_bgapi_class_coex_init();
 
 	gecko_initCoexHAL();
 
 	//Init retarget serial to use printf function
 	RETARGET_SerialInit();
+	serial_shell_init();
 
 	//Init button and led
 	button_init();
@@ -252,7 +282,13 @@ int main() {
 	LCD_init(header_buffer);
 
 	while (1) {
-		struct gecko_cmd_packet *evt = gecko_wait_event();
+		//Deferred work runs only while no stack event is waiting
+		struct gecko_cmd_packet *evt =
+				work_queue_pending() ? gecko_peek_event() : gecko_wait_event();
+		if (evt == NULL) {
+			work_queue_run(WORK_QUEUE_BUDGET_TICKS);
+			continue;
+		}
 		bool pass = mesh_bgapi_listener(evt);
 		if (pass) {
 			handle_gecko_event(BGLIB_MSG_ID(evt->header), evt);
@@ -284,8 +320,166 @@ static void led_init() {
  break;
  }
  }*/
+static void fill_snapshot(node_snapshot_t *snap) {
+	report_sched_state_t sched;
+	gw_health_info_t gw;
+	alarm_coalesce_stats_t alarm;
+	env_sensor_state_t env;
+	time_sync_state_t sync;
+	node_hb_state_t hb;
+	uint8 i;
+
+	snap->num_lpn = lpn_table.count;
+	if (snap->num_lpn > NODE_STORE_MAX_LPN) {
+		snap->num_lpn = NODE_STORE_MAX_LPN;
+	}
+	for (i = 0; i < snap->num_lpn; i++) {
+		snap->lpn_message[i] = lpn_table_message(i);
+		snap->lpn_time_out[i] = lpn_table.time_out[i];
+	}
+	snap->gateway_address = gateway_address;
+	for (i = 0; gw_health_get(i, &gw); i++) {
+		if (gw.address == gateway_address) {
+			snap->gateway_time_out = gw.misses;
+		}
+	}
+	snap->report_interval = report_interval;
+	report_sched_get_state(&sched);
+	snap->report_min_s = sched.min_s;
+	snap->report_max_s = sched.max_s;
+	snap->sched_enabled = sched.enabled;
+	alarm_coalesce_get_stats(&alarm);
+	snap->alarm_window_ms = alarm.window_ms;
+	env_sensor_get_state(&env);
+	snap->sensor_cadence_s = env.cadence_s;
+	time_sync_get_state(&sync);
+	snap->sync_interval_s = sync.interval_s;
+	node_hb_get_state(&hb);
+	snap->hb_period_log = hb.period_log;
+	snap->hb_ttl = hb.ttl;
+}
+
+/* Warm restart: take the LPN table and gateway state from before the reset so
+ * the first report is complete. Restored LPNs stay provisional until they make
+ * friends again and are dropped after PROVISIONAL_TIME_OUT sweep periods. */
+static bool restore_snapshot(void) {
+	node_snapshot_t snap;
+	uint8 lpn_index;
+	uint8 i;
+
+	if (!node_store_load(&snap)) {
+		return false;
+	}
+	lpn_table_init();
+	for (i = 0; i < snap.num_lpn; i++) {
+		lpn_index = lpn_table_add(get_unicast_address(snap.lpn_message[i]));
+		if (lpn_index == LPN_TABLE_NONE) {
+			break;
+		}
+		lpn_table_restore(lpn_index, snap.lpn_message[i],
+				snap.lpn_time_out[i]);
+	}
+	provisional_periods = 0;
+	lpn_table_take_dirty();
+	gw_health_restore(snap.gateway_address, snap.gateway_time_out);
+	gateway_address = gw_health_active();
+	report_sched_set_bounds(snap.report_min_s, snap.report_max_s);
+	report_sched_set_enabled(snap.sched_enabled);
+	receive_node_set_report_interval(snap.report_interval);
+	//The modules are not started yet, each takes its setting when it starts
+	alarm_coalesce_set_window(snap.alarm_window_ms);
+	env_sensor_set_cadence(snap.sensor_cadence_s);
+	time_sync_set_interval(snap.sync_interval_s);
+	node_hb_configure(snap.hb_period_log, snap.hb_ttl);
+	printf("Restored %d LPN, gateway %x\r\n", snap.num_lpn, gateway_address);
+	return true;
+}
+
+/* The terminated event carries no LPN address. A friendship ends when its
+ * LPN stops polling, so an entry the sweep found dead or a provisional one
+ * goes first, else the entry silent for the most sweep periods. The last
+ * entry moves into its slot, the others stay put. */
+static void release_quietest_lpn(void) {
+	uint8 released = lpn_table_evictable();
+	uint32 candidates = lpn_table.provisional | lpn_table_dead();
+	uint8 ties = 0;
+	uint8 i;
+
+	if (released == LPN_TABLE_NONE) {
+		released = lpn_table_quietest();
+		if (released == LPN_TABLE_NONE) {
+			return;
+		}
+		//A tie goes to an entry never heard from over one that was
+		candidates = (lpn_table.unheard & LPN_BIT(released)) ?
+				lpn_table.unheard : ~lpn_table.unheard;
+	}
+	for (i = 0; i < lpn_table.count; i++) {
+		if ((candidates & LPN_BIT(i))
+				&& lpn_table.time_out[i] == lpn_table.time_out[released]) {
+			ties++;
+		}
+	}
+	if (ties > 1) {
+		printf("Released LPN is a guess among %d\r\n", ties);
+	}
+	printf("LPN %x released\r\n", lpn_table.address[released]);
+	lpn_table_remove(released);
+	node_store_mark_dirty();
+}
+
+/* Repeats of a source's alarm within the coalescing window */
+static void send_alarm_summary(const alarm_summary_t *summary) {
+	uint16 repeats = summary->repeats > 0xff ? 0xff : summary->repeats;
+
+	if (vendor_data_gateway_ready()
+			&& vendor_data_send_alarm_summary(gateway_address, summary)) {
+		return;
+	}
+	//The latest alarm record, then the repeat count record
+	send_queue_push(SEND_PRIO_ALARM, FLAG_NON_RESPONSE, summary->message);
+	send_queue_push(SEND_PRIO_ALARM, FLAG_NON_RESPONSE,
+			((ALARM_SUMMARY_ADDRESS & 0x7f) << 1) | (repeats << 8));
+}
+
+static bool send_time_request(uint8 seq, uint32 local_ms) {
+	return vendor_data_send_time_request(gateway_address, seq, local_ms);
+}
+
+/* A vendor gateway gets the alarm with its time, as a summary without
+ * repeats; a level record has no room for it */
+static void send_alarm(uint16 source, uint16 message) {
+	uint32 now = app_time_ms();
+	alarm_summary_t alarm = { source, message, 0, now, now };
+
+	if (vendor_data_gateway_ready()
+			&& vendor_data_send_alarm_summary(gateway_address, &alarm)) {
+		return;
+	}
+	send_queue_push(SEND_PRIO_ALARM, FLAG_NON_RESPONSE, message);
+}
+
 void mesh_data_init() {
-	gateway_time_out = 0;
+	work_queue_init();
+	event_dispatch_init();
+	app_timer_init();
+	register_handlers();
+	gw_health_init();
+	node_hb_init();
+	lpn_table_init();
+	alarm_coalesce_init(send_alarm_summary);
+	time_sync_init(send_time_request);
+	dedup_cache_init(DEDUP_WINDOW_MS_DEFAULT);
+	send_queue_init(send_mesh_data);
+	report_sched_init();
+	node_stats_init();
+	env_sensor_init();
+	report_auth_init();
+	node_store_init(fill_snapshot);
+	vendor_data_init();
+	conn_policy_init();
+	event_trace_init();
+	prof_init();
 }
 void set_device_name(bd_addr *pAddr) {
 	char name[20];
@@ -308,7 +502,7 @@ void factory_reset() {
 	printf("***********************************************\r\n");
 
 	gecko_cmd_flash_ps_erase_all();
-	gecko_cmd_hardware_set_soft_timer(2 * 32768, TIMER_ID_FACTORY_RESET, 1);
+	app_timer_set(2 * 32768, TIMER_ID_FACTORY_RESET, 1);
 }
 
 void receive_node_init() {
@@ -327,64 +521,125 @@ void receive_node_init() {
 		printf("Friend init failed !!! \r\n");
 	}
 
+	//Pace outgoing reports to the network transmit state set by the provisioner
+	send_queue_update_pacing();
+	node_stats_start(NODE_STATS_PERIOD_S);
+
 	printf("Init gateway status\r\n");
-	gecko_cmd_hardware_set_soft_timer(15 * 32768,
-	TIMER_ID_CHECK_HEALTH, TIMER_REPEAT);
+	app_timer_set_lazy(report_interval * TIMER_CLOCK_FREQ,
+			APP_TIMER_SLACK(report_interval * TIMER_CLOCK_FREQ),
+			TIMER_ID_CHECK_HEALTH, TIMER_REPEAT);
+	health_timer_started = true;
+	app_timer_set_lazy(LPN_SWEEP_PERIOD_S * TIMER_CLOCK_FREQ,
+			APP_TIMER_SLACK(LPN_SWEEP_PERIOD_S * TIMER_CLOCK_FREQ),
+			TIMER_ID_LPN_SWEEP, TIMER_REPEAT);
 	/*gecko_cmd_hardware_set_soft_timer(3 * 32768, TIMER_ID_SEND_MESSAGE,
 	 TIMER_REPEAT);*/
-	mesh_lib_generic_server_register_handler(
+	//Level state changes carry nothing the node uses
+	mesh_lib_generic_server_register_raw_handler(
 	MESH_GENERIC_LEVEL_SERVER_MODEL_ID, primary_element, pri_level_request,
-			pri_level_change);
+			NULL);
+
+	//Own temperature and humidity through the Sensor Server
+	env_sensor_start(primary_element);
+	report_auth_start();
+	vendor_data_start(primary_element);
+	gw_health_start();
+	node_hb_start(gateway_address);
+	time_sync_start();
+
+}
+
+uint16 receive_node_get_report_interval(void) {
+	return report_interval;
+}
+
+bool receive_node_set_report_interval(uint16 seconds) {
+	if (seconds < REPORT_INTERVAL_MIN || seconds > REPORT_INTERVAL_MAX) {
+		return false;
+	}
+	if (seconds != report_interval) {
+		node_store_mark_dirty();
+	}
+	report_interval = seconds;
+	//Restart the running health timer with the new period
+	if (health_timer_started) {
+		app_timer_set_lazy(report_interval * TIMER_CLOCK_FREQ,
+				APP_TIMER_SLACK(report_interval * TIMER_CLOCK_FREQ),
+				TIMER_ID_CHECK_HEALTH, TIMER_REPEAT);
+	}
+	return true;
+}
 
+static void gateway_command(uint16 message) {
+	report_sched_state_t sched;
+	uint16 arg = get_gateway_cmd_arg(message);
+
+	report_sched_get_state(&sched);
+	switch (get_gateway_cmd(message)) {
+	case GATEWAY_CMD_REPORT_MIN:
+		node_store_mark_dirty();
+		report_sched_set_bounds(arg, sched.max_s);
+		break;
+	case GATEWAY_CMD_REPORT_MAX:
+		node_store_mark_dirty();
+		report_sched_set_bounds(sched.min_s, arg * GATEWAY_CMD_MAX_UNIT_S);
+		break;
+	default:
+		break;
+	}
 }
 
-static void pri_level_request(uint16_t model_id, uint16_t element_index,
-		uint16_t client_addr, uint16_t server_addr, uint16_t appkey_index,
-		const struct mesh_generic_request *request, uint32_t transition_ms,
-		uint16_t delay_ms, uint8_t request_flags) {
+/* Takes the level straight from the message, no mesh_generic_request is
+ * built for it */
+static void pri_level_request(const struct mesh_lib_request_view *view) {
+	uint16_t client_addr = view->evt->client_address;
+	int16_t level;
+	PROF_SCOPE(PROF_PRI_LEVEL_REQUEST);
 	//printf("evt handle\r\n");
-	if (request->kind != mesh_generic_request_level) {
+	if (mesh_lib_request_view_kind(view) != mesh_generic_request_level
+			|| mesh_lib_request_view_level(view, &level) != 0) {
 		return;
 	}
-	if(client_addr == 1){
-		gateway_time_out = 0;
+	uint16 message = (uint16) level;
+	//Drop copies delivered again by the friend queue or relays, before
+	//anything reaches the coalescer or goes upstream; dedup counts them
+	if (dedup_cache_check(client_addr, message)) {
 		return;
 	}
-	if (get_alarm_signal(request->level)){
-		// chuyen? len gateway ngay;
-		send_mesh_data(FLAG_NON_RESPONSE, FLAG_NON_RETRANS, request->level);
+	if (gw_health_is_gateway(client_addr)) {
+		gw_health_note_traffic(client_addr);
+		if (get_unicast_address(message) == GATEWAY_CMD_ADDRESS) {
+			gateway_command(message);
+		}
 		return;
 	}
 	// thuc. hien cap nhat.
-	int i = 0;
-	for (; i < mesh_lpn_data_array.num_lpn; i++) {
-		if(mesh_lpn_data_array.mesh_lpn_data[i].unicast_address == get_unicast_address(request->level))
-		{
-			mesh_lpn_data_array.mesh_lpn_data[i] = message2data(request->level);
-			return;
+	uint8 lpn_index = lpn_table_find(get_unicast_address(message));
+	if (lpn_index != LPN_TABLE_NONE) {
+		//Changes are picked up by the health timer sweep
+		lpn_table_update(lpn_index, message);
+	}
+	if (get_alarm_signal(message)){
+		report_sched_note_alarm();
+		// chuyen? len gateway ngay;
+		if (alarm_coalesce_note(client_addr, message)) {
+			send_alarm(client_addr, message);
 		}
 	}
-
 }
-static void pri_level_change(uint16_t model_id, uint16_t element_index,
-		const struct mesh_generic_state *current,
-		const struct mesh_generic_state *target, uint32_t remaining_ms) {
-}
-void send_mesh_data(uint8 response_flag, uint8 retransmit, uint16 message) {
+uint16 send_mesh_data(uint8 response_flag, uint8 retransmit, uint16 message) {
 	uint16 resp;
 	uint32_t transition_ms = 0;
 	uint16_t delay_ms = 0;
 	uint16 element_index = 0;
 	struct mesh_generic_request req;
-
-	printf("Send Mesh Data Function \r\n");
-	printf("***********************\r\n");
+	PROF_SCOPE(PROF_SEND_MESH_DATA);
 
 	req.kind = mesh_generic_request_level;
 	req.level = message;
 
 	//uint16 test = set_mesh_data(&node_data_arr[element_index]);
-	printf("node data %x \r\n", req.level);
 	/* Increase transaction_id after each packet sent with non - retransmition */
 	if (retransmit == FLAG_NON_RETRANS) {
 		transaction_id++;
@@ -397,14 +652,30 @@ void send_mesh_data(uint8 response_flag, uint8 retransmit, uint16 message) {
 	MESH_GENERIC_LEVEL_CLIENT_MODEL_ID, element_index, gateway_address,
 	APP_KEY_INDEX, transaction_id, &req, transition_ms, delay_ms,
 			response_flag);
+	//Only failures are logged, a print per send costs more than the send
 	if (resp) {
 		printf("Send Mesh data failed !!! \r\n");
-	} else {
-		printf("Mesh data sent %x!!! \r\n", req.level);
 	}
+	return resp;
+}
+/* Mains powered by default, a board with a battery gauge overrides this */
+__attribute__((weak)) uint8 receive_node_battery_percent(void) {
+	return 100;
+}
+
+/* Own record of the report: alive, battery, and the alarm bit for a node
+ * health fault */
+static uint16 self_record(uint16 address) {
+	stack_mon_state_t stack;
+
+	stack_mon_get_state(&stack);
+	return (stack.warned ? 0x01 : 0) | ((address & 0x7f) << 1) | (1 << 8)
+			| ((receive_node_battery_percent() & 0x7f) << 9);
 }
-void send_data_array2gateway(){
+
+void send_data_array2gateway(uint32 changed){
 	struct gecko_msg_mesh_node_get_element_address_rsp_t *node_address;
+	send_queue_stats_t sq;
 
 		node_address = gecko_cmd_mesh_node_get_element_address(primary_element);
 		if (node_address->result == 0) {
@@ -412,247 +683,425 @@ void send_data_array2gateway(){
 		} else {
 			printf("Get Unicast address from Promary element failed !!! \r\n");
 		}
-	uint16 this_friend_node_data = 0x0;
-	this_friend_node_data |= node_address->address <<1;
-	this_friend_node_data |= 1 <<8;
-	this_friend_node_data |= 100 <<9;
-	send_mesh_data(FLAG_RESPONSE, FLAG_NON_RETRANS, this_friend_node_data);
+	//The response buffer is reused by the next command
+	uint16 this_address = node_address->address;
+	uint16 this_friend_node_data = self_record(this_address);
+	//One vendor message carries the whole table once the gateway speaks it
+	if (vendor_data_gateway_ready()
+			&& vendor_data_send_report(gateway_address, this_address,
+					this_friend_node_data)) {
+		return;
+	}
+	//The tag covers the records in the order they go out: changed records
+	//only jump ahead when no record of an earlier report is still queued
+	send_queue_get_stats(&sq);
+	if (sq.pending[SEND_PRIO_STATE] || sq.pending[SEND_PRIO_PERIODIC]) {
+		changed = 0;
+	}
+	report_auth_begin(this_address);
 	uint8 i;
-	for (i = 0; i < mesh_lpn_data_array.num_lpn; i++){
-		send_mesh_data(FLAG_NON_RESPONSE, FLAG_NON_RETRANS, data2message(mesh_lpn_data_array.mesh_lpn_data[i]));
+	for (i = 0; i < lpn_table.count; i++){
+		if (changed & LPN_BIT(i)) {
+			uint16 message = lpn_table_message(i);
+			send_queue_push(SEND_PRIO_STATE, FLAG_NON_RESPONSE, message);
+			report_auth_add(message);
+		}
 	}
+	//Liveness goes by heartbeat, the own record needs no acknowledgement
+	send_queue_push(SEND_PRIO_PERIODIC, FLAG_NON_RESPONSE, this_friend_node_data);
+	report_auth_add(this_friend_node_data);
+	for (i = 0; i < lpn_table.count; i++){
+		if (!(changed & LPN_BIT(i))) {
+			uint16 message = lpn_table_message(i);
+			send_queue_push(SEND_PRIO_PERIODIC, FLAG_NON_RESPONSE, message);
+			report_auth_add(message);
+		}
+	}
+	report_auth_finish();
 }
-static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt) {
+/* The report loops over the table and sends, it runs as deferred work. arg
+ * holds the LPN entries changed since the last report. */
+static void report_work(uint32 arg) {
+	send_data_array2gateway(arg);
+}
+
+static void display_show_page(void) {
+	char row0[LCD_ROW_LEN + 1];
+	char row1[LCD_ROW_LEN + 1];
+	send_queue_stats_t tx;
+	env_sensor_state_t env;
+
+	switch (display_page) {
+	case 0:
+		snprintf(row0, sizeof(row0), "LPN: %d", lpn_table.count);
+		snprintf(row1, sizeof(row1), "Report: %d s", report_interval);
+		break;
+	case 1:
+		send_queue_get_stats(&tx);
+		snprintf(row0, sizeof(row0), "TX sent %lu", (unsigned long) tx.sent);
+		snprintf(row1, sizeof(row1), "drop %lu fail %lu",
+				(unsigned long) tx.dropped, (unsigned long) tx.failed);
+		break;
+	default:
+		env_sensor_get_state(&env);
+		snprintf(row0, sizeof(row0), "T %s%d.%d C",
+				env.temperature < 0 ? "-" : "", abs(env.temperature) / 2,
+				(abs(env.temperature) % 2) * 5);
+		snprintf(row1, sizeof(row1), "RH %u.%02u %%", env.humidity / 100,
+				env.humidity % 100);
+		break;
+	}
+	LCD_write(row0, LCD_ROW_SENSOR_00);
+	LCD_write(row1, LCD_ROW_SENSOR_01);
+}
+
+/* Button 0 forces a report and button 1 pages the display, a double press
+ * restarts the node and a long press does a factory reset */
+static void button_pressed(uint8 button, button_press_t press) {
+	switch (press) {
+	case BUTTON_PRESS_SHORT:
+		if (button == 1) {
+			display_page = (display_page + 1) % DISPLAY_PAGES;
+			display_show_page();
+		} else if (health_timer_started) {
+			printf("Report forced by button\r\n");
+			work_queue_post(WORK_PRIO_NORMAL, report_work, 0);
+		}
+		break;
+	case BUTTON_PRESS_DOUBLE:
+		printf("Restart by button\r\n");
+		app_timer_set(TIMER_MILLIS_SECONDS(100),
+		TIMER_ID_RESTART, 1);
+		break;
+	case BUTTON_PRESS_LONG:
+		factory_reset();
+		break;
+	}
+}
+
+static void stack_low(uint32 used, uint32 size) {
+	printf("Stack watermark %lu of %lu bytes !!!\r\n", (unsigned long) used,
+			(unsigned long) size);
+	LCD_write("STACK LOW", LCD_ROW_ERR);
+}
+
+/* Runs in interrupt context, I2C callbacks are delivered from the main loop */
+void I2CASYNC_CompletionHook(void) {
+	gecko_external_signal(I2C_EXT_SIGNAL);
+}
+
+static void on_factory_reset_timer(void) {
+	gecko_cmd_system_reset(0);
+}
+
+static void on_restart_timer(void) {
+	node_store_flush();
+	gecko_cmd_system_reset(0);
+}
+
+static void on_blink_timer(void) {
+	GPIO_PinOutToggle(BSP_LED0_PORT, BSP_LED0_PIN);
+	GPIO_PinOutToggle(BSP_LED1_PORT, BSP_LED1_PIN);
+}
+
+static void on_lpn_sweep_timer(void) {
+	if (lpn_table_sweep(MAX_TIME_OUT)) {
+		node_store_mark_dirty();
+	}
+	if (lpn_table.provisional && ++provisional_periods > PROVISIONAL_TIME_OUT) {
+		printf("%d restored LPN dropped\r\n", lpn_table_drop_provisional());
+		node_store_mark_dirty();
+	}
+}
+
+static void on_health_timer(void) {
+	printf("CHECK HEALTH\r\n");
+	//LPNs lost since the last report were marked dirty by the sweep
+	uint32 changed = lpn_table_take_dirty();
+	if (changed) {
+		report_sched_note_change();
+		node_store_mark_dirty();
+	}
+	//The periodic backlog is judged before this tick's report joins it
+	uint16 next_interval = report_sched_update(report_interval);
+	if (next_interval != report_interval) {
+		printf("Report interval %d s\r\n", next_interval);
+		receive_node_set_report_interval(next_interval);
+	}
+	work_queue_post(WORK_PRIO_NORMAL, report_work, changed);
+}
+
+static void on_boot(struct gecko_cmd_packet *evt) {
 	uint16 result;
 	char buf[30];
 
-	if (evt == NULL) {
+	if (GPIO_PinInGet(BSP_BUTTON0_PORT, BSP_BUTTON0_PIN) == 0
+			|| GPIO_PinInGet(BSP_BUTTON1_PORT, BSP_BUTTON1_PIN) == 0) {
+		factory_reset();
 		return;
 	}
+	//Buttons act at runtime once the boot check is done
+	buttons_init(button_pressed);
+	stack_mon_start(stack_low);
 
-	switch (evt_id) {
-	case gecko_evt_system_boot_id:
-		if (GPIO_PinInGet(BSP_BUTTON0_PORT, BSP_BUTTON0_PIN) == 0
-				|| GPIO_PinInGet(BSP_BUTTON1_PORT, BSP_BUTTON1_PIN) == 0) {
-			factory_reset();
-		} else {
-			struct gecko_msg_system_get_bt_address_rsp_t *pAddr =
-					gecko_cmd_system_get_bt_address();
+	struct gecko_msg_system_get_bt_address_rsp_t *pAddr =
+			gecko_cmd_system_get_bt_address();
 
-			set_device_name(&pAddr->address);
+	set_device_name(&pAddr->address);
 
-			result = gecko_cmd_mesh_node_init()->result;
+	result = gecko_cmd_mesh_node_init()->result;
 
-			if (result) {
-				sprintf(buf, "Init Failed");
+	if (result) {
+		sprintf(buf, "Init Failed");
 
-				printf("Bluetooth Mesh Stack Init Failed !!!!!!\r\n");
+		printf("Bluetooth Mesh Stack Init Failed !!!!!!\r\n");
 
-				LCD_write(buf, LCD_ROW_ERR);
-			}
-		}
-		break;
+		LCD_write(buf, LCD_ROW_ERR);
+	}
+}
 
-	case gecko_evt_hardware_soft_timer_id:
-		switch (evt->data.evt_hardware_soft_timer.handle) {
-		case TIMER_ID_FACTORY_RESET:
-			gecko_cmd_system_reset(0);
-			break;
+static void on_external_signal(struct gecko_cmd_packet *evt) {
+	if (evt->data.evt_system_external_signal.extsignals & SHELL_EXT_SIGNAL) {
+		serial_shell_process();
+	}
+	if (evt->data.evt_system_external_signal.extsignals & I2C_EXT_SIGNAL) {
+		I2CASYNC_Process();
+	}
+	if (evt->data.evt_system_external_signal.extsignals & BUTTON_EXT_SIGNAL) {
+		buttons_process();
+	}
+}
 
-		case TIMER_ID_RESTART:
-			gecko_cmd_system_reset(0);
-			break;
+static void on_node_initialized(struct gecko_cmd_packet *evt) {
+	uint16 result;
 
-		case TIMER_ID_BLINK_LED:
-			GPIO_PinOutToggle(BSP_LED0_PORT, BSP_LED0_PIN);
-			GPIO_PinOutToggle(BSP_LED1_PORT, BSP_LED1_PIN);
-			break;
-			//TODO
-		case TIMER_ID_CHECK_HEALTH: {
-			printf("CHECK HEALTH\r\n");
-			gateway_time_out++;
-			if(gateway_time_out > MAX_TIME_OUT){
-				gateway_address = 2;
-			}
-			else
-				gateway_address = 1;
-			//nho' reset bien timeOut khi nhan dc goi' tin tu` Gateway
-			uint8 i = 0;
-			for(;i < mesh_lpn_data_array.num_lpn; i++){
-				mesh_lpn_data_array.mesh_lpn_data[i].time_out++;
-				if(mesh_lpn_data_array.mesh_lpn_data[i].time_out > MAX_TIME_OUT){
-					mesh_lpn_data_array.mesh_lpn_data[i].heart_beat = 0;
-				}
-			}
-			send_data_array2gateway();
-		}
-			break;
-		default:
-			break;
-		}
-		break;
-	case gecko_evt_mesh_node_initialized_id:
-		printf("Node initialized !!! \r\n");
+	printf("Node initialized !!! \r\n");
 
-		result = gecko_cmd_mesh_generic_server_init()->result;
-		if (result) {
-			printf("Generic Sever Init failed !!! \r\n");
-		}
-		result = gecko_cmd_mesh_generic_client_init()->result;
-		if (result) {
-			printf("Generic Client Init failed !!! \r\n");
-		}
-		if (!evt->data.evt_mesh_node_initialized.provisioned) {
-			LCD_write("Unprovisioned !!!", LCD_ROW_INFO);
+	result = gecko_cmd_mesh_generic_server_init()->result;
+	if (result) {
+		printf("Generic Sever Init failed !!! \r\n");
+	}
+	result = gecko_cmd_mesh_generic_client_init()->result;
+	if (result) {
+		printf("Generic Client Init failed !!! \r\n");
+	}
+	if (!evt->data.evt_mesh_node_initialized.provisioned) {
+		LCD_write("Unprovisioned !!!", LCD_ROW_INFO);
 
-			printf("Device Unprovisioned !!!!!!\r\n");
+		printf("Device Unprovisioned !!!!!!\r\n");
 
-			// The Node is now initialized, start unprovisioned Beaconing using PB-ADV and PB-GATT Bearers
-			gecko_cmd_mesh_node_start_unprov_beaconing(0x3);
-		} else {
-			LCD_write("Provisioned !!!", LCD_ROW_INFO);
+		// The Node is now initialized, start unprovisioned Beaconing using PB-ADV and PB-GATT Bearers
+		gecko_cmd_mesh_node_start_unprov_beaconing(0x3);
+	} else {
+		LCD_write("Provisioned !!!", LCD_ROW_INFO);
 
-			printf("Device Provisioned !!!!!!\r\n");
+		printf("Device Provisioned !!!!!!\r\n");
 
-			receive_node_init();
+		bool warm = restore_snapshot();
+		receive_node_init();
+		if (warm) {
+			work_queue_post(WORK_PRIO_NORMAL, report_work, 0);
 		}
-		break;
+	}
+}
 
-	case gecko_evt_mesh_node_provisioning_started_id:
-		LCD_write("Provisioning...", LCD_ROW_INFO);
+static void on_gateway_heartbeat(struct gecko_cmd_packet *evt) {
+	if (gw_health_on_complete(
+			&evt->data.evt_mesh_test_local_heartbeat_subscription_complete)) {
+		gateway_address = gw_health_active();
+		node_hb_set_destination(gateway_address);
+		time_sync_on_gateway_change();
+		node_store_mark_dirty();
+	}
+}
 
-		printf("Provisioning Process !!!!!!\r\n");
-		gecko_cmd_hardware_set_soft_timer(TIMER_MILLIS_SECONDS(1000),
-		TIMER_ID_BLINK_LED, 0);
-		break;
+static void on_provisioning_started(struct gecko_cmd_packet *evt) {
+	LCD_write("Provisioning...", LCD_ROW_INFO);
 
-	case gecko_evt_mesh_node_provisioned_id:
-		LCD_write("Provisioned !!!", LCD_ROW_INFO);
+	printf("Provisioning Process !!!!!!\r\n");
+	app_timer_set(TIMER_MILLIS_SECONDS(1000),
+	TIMER_ID_BLINK_LED, 0);
+}
 
-		printf("Device Provisioned !!!!!!\r\n");
-		receive_node_init();
-		gecko_cmd_hardware_set_soft_timer(0, TIMER_ID_BLINK_LED, 1);
-		GPIO_PinOutClear(BSP_LED0_PORT, BSP_LED0_PIN);
-		GPIO_PinOutClear(BSP_LED1_PORT, BSP_LED1_PIN);
-		break;
+static void on_provisioned(struct gecko_cmd_packet *evt) {
+	LCD_write("Provisioned !!!", LCD_ROW_INFO);
 
-	case gecko_evt_mesh_node_provisioning_failed_id:
-		LCD_write("Prov Failed !!!", LCD_ROW_INFO);
+	printf("Device Provisioned !!!!!!\r\n");
+	receive_node_init();
+	app_timer_set(0, TIMER_ID_BLINK_LED, 1);
+	GPIO_PinOutClear(BSP_LED0_PORT, BSP_LED0_PIN);
+	GPIO_PinOutClear(BSP_LED1_PORT, BSP_LED1_PIN);
+}
 
-		printf("Provisioning Process Failed !!!!!!\r\n");
+static void on_provisioning_failed(struct gecko_cmd_packet *evt) {
+	LCD_write("Prov Failed !!!", LCD_ROW_INFO);
 
-		gecko_cmd_hardware_set_soft_timer(2 * 32768, TIMER_ID_RESTART, 1);
-		break;
+	printf("Provisioning Process Failed !!!!!!\r\n");
 
-	case gecko_evt_mesh_node_key_added_id:
-		printf("New key !!!! \r\n");
-		break;
+	app_timer_set(2 * 32768, TIMER_ID_RESTART, 1);
+}
 
-	case gecko_evt_mesh_node_model_config_changed_id:
-		printf("Mesh node model config changed !!! \r\n");
-		break;
+static void on_key_added(struct gecko_cmd_packet *evt) {
+	printf("New key !!!! \r\n");
+}
 
-	case gecko_evt_mesh_generic_server_client_request_id:
-		printf("Receive message from %d  !!! \r\n",
-				evt->data.evt_mesh_generic_server_client_request.client_address);
-		mesh_lib_generic_server_event_handler(evt);
-		break;
+static void on_model_config_changed(struct gecko_cmd_packet *evt) {
+	printf("Mesh node model config changed !!! \r\n");
+}
 
-	case gecko_evt_mesh_generic_client_server_status_id:
-		printf("Received response");
-		break;
+static void on_client_request(struct gecko_cmd_packet *evt) {
+	printf("Receive message from %d  !!! \r\n",
+			evt->data.evt_mesh_generic_server_client_request.client_address);
+	mesh_lib_generic_server_event_handler(evt);
+}
 
-	case gecko_evt_mesh_generic_server_state_changed_id:
-		printf("Server state changed !!! \r\n");
-		mesh_lib_generic_server_event_handler(evt);
-		break;
+static void on_server_status(struct gecko_cmd_packet *evt) {
+	printf("Received response");
+}
 
-	case gecko_evt_mesh_node_reset_id:
-		printf("Event gecko_evt_mesh_node_reset_id !!! \r\n");
-		factory_reset();
-		break;
+static void on_server_state_changed(struct gecko_cmd_packet *evt) {
+	printf("Server state changed !!! \r\n");
+	mesh_lib_generic_server_event_handler(evt);
+}
 
-	case gecko_evt_mesh_friend_friendship_established_id:
-		LCD_write("FRIEND", LCD_ROW_FRIEND_INFOR);
-		printf("Event gecko_evt_mesh_friend_friendship_established !!! \r\n");
-		num_lpn++;
-		printf("num_lpn %d \r\n", num_lpn);
-		uint16 new_friendship_address =
-				evt->data.evt_mesh_friend_friendship_established.lpn_address;
-		if (mesh_lpn_data_array.num_lpn < MESH_CFG_MAX_FRIENDSHIPS) {
-			mesh_lpn_data_array.mesh_lpn_data = (mesh_lpn_data_str *) realloc(
-					mesh_lpn_data_array.mesh_lpn_data,
-					sizeof(mesh_lpn_data_str)
-							* (mesh_lpn_data_array.num_lpn
-									+ 1));
-			mesh_lpn_data_array.mesh_lpn_data[mesh_lpn_data_array.num_lpn] = message2data((new_friendship_address& 0x7f)<<1);
-			mesh_lpn_data_array.num_lpn++;
-		} else {
-			printf("Max number of friendship was established");
+static void on_node_reset(struct gecko_cmd_packet *evt) {
+	printf("Event gecko_evt_mesh_node_reset_id !!! \r\n");
+	factory_reset();
+}
+
+static void on_friendship_established(struct gecko_cmd_packet *evt) {
+	LCD_write("FRIEND", LCD_ROW_FRIEND_INFOR);
+	printf("Event gecko_evt_mesh_friend_friendship_established !!! \r\n");
+	num_lpn++;
+	printf("num_lpn %d \r\n", num_lpn);
+	uint16 new_friendship_address =
+			evt->data.evt_mesh_friend_friendship_established.lpn_address;
+	//An LPN restored from the snapshot keeps its entry
+	uint8 lpn_index = lpn_table_find(new_friendship_address & 0x7f);
+	if (lpn_index != LPN_TABLE_NONE) {
+		lpn_table.time_out[lpn_index] = 0;
+		lpn_table_confirm(lpn_index);
+		return;
+	}
+	//A full table gives up an LPN that is gone or was only restored
+	if (lpn_table.count >= LPN_TABLE_MAX) {
+		lpn_index = lpn_table_evictable();
+		if (lpn_index == LPN_TABLE_NONE) {
+			printf("Max number of friendship was established\r\n");
+			return;
 		}
-		//printf("LPN stats:%d\t %d\t%d\r\n", lpn_status_arr[num_lpn].address, lpn_status_arr[num_lpn].timeOut);
-		break;
+		printf("LPN %x evicted\r\n", lpn_table.address[lpn_index]);
+		lpn_table_remove(lpn_index);
+	}
+	lpn_table_add(new_friendship_address & 0x7f);
+	node_store_mark_dirty();
+}
 
-	case gecko_evt_mesh_friend_friendship_terminated_id:
-		printf("Event gecko_evt_mesh_friend_friendship_terminated !!!\r\n");
+static void on_friendship_terminated(struct gecko_cmd_packet *evt) {
+	printf("Event gecko_evt_mesh_friend_friendship_terminated 0x%x !!!\r\n",
+			evt->data.evt_mesh_friend_friendship_terminated.reason);
+	//The other friendships and their friend queues are left running
+	release_quietest_lpn();
+	if (num_lpn > 0) {
+		num_lpn--;
+	}
+	if (lpn_table.count == 0) {
 		LCD_write("NO LPN", LCD_ROW_FRIEND_INFOR);
-		gecko_cmd_mesh_friend_deinit();
-		//clear_lpn_status_arr(lpn_status_arr, num_lpn);
-		free(mesh_lpn_data_array.mesh_lpn_data);
-		//tao. delay
-		uint8 i = 0;
-		for(;i < 100;i++){}
-
-		gecko_cmd_mesh_friend_init();
-		break;
+	}
+}
 
-	case gecko_evt_le_connection_opened_id:
-		printf("Open BLE connection !!! \r\n");
-		num_connections++;
-		connection_handle = evt->data.evt_le_connection_opened.connection;
-		LCD_write("Connected !!!", LCD_ROW_CONNECTION);
-		break;
+static void on_connection_opened(struct gecko_cmd_packet *evt) {
+	printf("Open BLE connection !!! \r\n");
+	num_connections++;
+	connection_handle = evt->data.evt_le_connection_opened.connection;
+	LCD_write("Connected !!!", LCD_ROW_CONNECTION);
+}
 
-	case gecko_evt_le_connection_closed_id:
-		if (boot_to_dfu) {
-			gecko_cmd_system_reset(2);
-		}
+static void on_connection_closed(struct gecko_cmd_packet *evt) {
+	if (boot_to_dfu) {
+		gecko_cmd_system_reset(2);
+	}
 
-		printf("Close BLE connection !!! \r\n");
-		connection_handle = 0xFF;
-		if (num_connections > 0) {
-			if (--num_connections == 0) {
-				LCD_write("", LCD_ROW_CONNECTION);
-			}
+	printf("Close BLE connection !!! \r\n");
+	connection_handle = 0xFF;
+	if (num_connections > 0) {
+		if (--num_connections == 0) {
+			LCD_write("", LCD_ROW_CONNECTION);
 		}
-		break;
-
-	case gecko_evt_le_connection_parameters_id:
-		printf("BLE connection parameter: interval %d, timeout %d \r\n",
-				evt->data.evt_le_connection_parameters.interval,
-				evt->data.evt_le_connection_parameters.timeout);
-		break;
+	}
+}
 
-	case gecko_evt_le_gap_adv_timeout_id:
-		break;
+static void on_connection_parameters(struct gecko_cmd_packet *evt) {
+	printf("BLE connection parameter: interval %d, timeout %d \r\n",
+			evt->data.evt_le_connection_parameters.interval,
+			evt->data.evt_le_connection_parameters.timeout);
+}
 
-	case gecko_evt_gatt_server_user_write_request_id:
-		if (evt->data.evt_gatt_server_user_write_request.characteristic
-				== gattdb_ota_control) {
-			boot_to_dfu = 1;
+static void on_user_write_request(struct gecko_cmd_packet *evt) {
+	if (evt->data.evt_gatt_server_user_write_request.characteristic
+			== gattdb_ota_control) {
+		boot_to_dfu = 1;
 
-			gecko_cmd_gatt_server_send_user_write_response(
-					evt->data.evt_gatt_server_user_write_request.connection,
-					gattdb_ota_control, bg_err_success);
+		gecko_cmd_gatt_server_send_user_write_response(
+				evt->data.evt_gatt_server_user_write_request.connection,
+				gattdb_ota_control, bg_err_success);
 
-			gecko_cmd_le_connection_close(
-					evt->data.evt_gatt_server_user_write_request.connection);
-		}
-		break;
+		gecko_cmd_le_connection_close(
+				evt->data.evt_gatt_server_user_write_request.connection);
+	}
+}
 
-	default:
-		break;
+/* Events and timers of this file, the modules register their own */
+static void register_handlers(void) {
+	event_dispatch_register(gecko_evt_system_boot_id, on_boot);
+	event_dispatch_register(gecko_evt_system_external_signal_id,
+			on_external_signal);
+	event_dispatch_register(gecko_evt_mesh_node_initialized_id,
+			on_node_initialized);
+	event_dispatch_register(
+			gecko_evt_mesh_test_local_heartbeat_subscription_complete_id,
+			on_gateway_heartbeat);
+	event_dispatch_register(gecko_evt_mesh_node_provisioning_started_id,
+			on_provisioning_started);
+	event_dispatch_register(gecko_evt_mesh_node_provisioned_id,
+			on_provisioned);
+	event_dispatch_register(gecko_evt_mesh_node_provisioning_failed_id,
+			on_provisioning_failed);
+	event_dispatch_register(gecko_evt_mesh_node_key_added_id, on_key_added);
+	event_dispatch_register(gecko_evt_mesh_node_model_config_changed_id,
+			on_model_config_changed);
+	event_dispatch_register(gecko_evt_mesh_generic_server_client_request_id,
+			on_client_request);
+	event_dispatch_register(gecko_evt_mesh_generic_client_server_status_id,
+			on_server_status);
+	event_dispatch_register(gecko_evt_mesh_generic_server_state_changed_id,
+			on_server_state_changed);
+	event_dispatch_register(gecko_evt_mesh_node_reset_id, on_node_reset);
+	event_dispatch_register(gecko_evt_mesh_friend_friendship_established_id,
+			on_friendship_established);
+	event_dispatch_register(gecko_evt_mesh_friend_friendship_terminated_id,
+			on_friendship_terminated);
+	event_dispatch_register(gecko_evt_le_connection_opened_id,
+			on_connection_opened);
+	event_dispatch_register(gecko_evt_le_connection_closed_id,
+			on_connection_closed);
+	event_dispatch_register(gecko_evt_le_connection_parameters_id,
+			on_connection_parameters);
+	event_dispatch_register(gecko_evt_gatt_server_user_write_request_id,
+			on_user_write_request);
+
+	app_timer_register(TIMER_ID_FACTORY_RESET, on_factory_reset_timer);
+	app_timer_register(TIMER_ID_RESTART, on_restart_timer);
+	app_timer_register(TIMER_ID_BLINK_LED, on_blink_timer);
+	app_timer_register(TIMER_ID_CHECK_HEALTH, on_health_timer);
+	app_timer_register(TIMER_ID_LPN_SWEEP, on_lpn_sweep_timer);
+}
 
+static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt) {
+	if (evt == NULL) {
+		return;
 	}
+	PROF_SCOPE(PROF_HANDLE_EVENT);
+	event_trace_record(evt);
+	event_dispatch(evt_id, evt);
 }
-
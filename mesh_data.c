@@ -0,0 +1,14 @@
+#include "mesh_data.h"
+
+uint16 get_unicast_address(uint16 message) {
+	return (message >> 1) & 0x007f;
+}
+uint8 get_alarm_signal(uint8 message){
+	return message & 0x01 ;
+}
+uint8 get_gateway_cmd(uint16 message) {
+	return (message >> 8) & 0x01;
+}
+uint8 get_gateway_cmd_arg(uint16 message) {
+	return (message >> 9) & 0x7f;
+}
@@ -1,6 +1,8 @@
 #ifndef MESH_DATA_H
 #define MESH_DATA_H
 
+#include "bg_types.h"
+
 #define ALARM_ON                   0x03
 #define ALARM_OFF                  0x00
 
@@ -8,43 +10,20 @@
 
 #define DEFAULT_ARRAY_SIZE          8
 
-typedef struct {
-	uint8 alarm_signal;
-	uint16 unicast_address;
-	uint8 heart_beat;
-	uint8 battery_percent;
-	uint8 time_out;
-}mesh_lpn_data_str;
-typedef struct{
-	mesh_lpn_data_str* mesh_lpn_data;
-	uint16 num_lpn;
-	uint16 current_lpn_node;
-}mesh_lpn_data_array_t;
-
-uint16 data2message(mesh_lpn_data_str mesh_data) {
-	uint16 data = 0x0000;
-	data = data | (mesh_data.alarm_signal & 0x01);
-	data = data | ((mesh_data.unicast_address & 0x7f) << 1);
-	data = data | ((mesh_data.heart_beat & 0x01) << 8);
-	data = data | ((mesh_data.battery_percent & 0x7f) << 9);
-	return data;
-}
-
-mesh_lpn_data_str message2data(uint16 data) {
-	mesh_lpn_data_str mesh_data;
-	mesh_data.alarm_signal = data & 0x01;
-	mesh_data.unicast_address = (data >> 1) & 0x7f;
-	mesh_data.heart_beat = (data >> 8) & 0x01;
-	mesh_data.battery_percent = (data >> 9) & 0x7f;
-	mesh_data.time_out = 0;
-	return mesh_data;
-}
-
-uint16 get_unicast_address(uint16 message) {
-	return (message >> 1) & 0x007f;
-}
-uint8 get_alarm_signal(uint8 message){
-	return message & 0x01 ;
-}
+/* A gateway message with this address field carries a configuration command:
+ * bit 8 selects the command, bits 9..15 hold its 7 bit argument */
+#define GATEWAY_CMD_ADDRESS        0x7f
+#define GATEWAY_CMD_REPORT_MIN     0   /* argument in seconds */
+#define GATEWAY_CMD_REPORT_MAX     1   /* argument in GATEWAY_CMD_MAX_UNIT_S */
+#define GATEWAY_CMD_MAX_UNIT_S     30
+
+/* Friend node radio statistics sent to the gateway: bit 0 is set on any
+ * error or denial in the period, bits 8..15 hold TX + RX packets per second */
+#define NODE_STATS_ADDRESS         0x7e
+
+uint16 get_unicast_address(uint16 message);
+uint8 get_alarm_signal(uint8 message);
+uint8 get_gateway_cmd(uint16 message);
+uint8 get_gateway_cmd_arg(uint16 message);
 
 #endif
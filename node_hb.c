@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_hb.c
+ * The stack sends the heartbeats itself, unacknowledged and without waking
+ * the application, in place of the self record the node used to send as an
+ * acknowledged level set every report.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "node_hb.h"
+
+static node_hb_state_t hb;
+
+void node_hb_init(void) {
+	memset(&hb, 0, sizeof(hb));
+	hb.period_log = NODE_HB_PERIOD_LOG_DEFAULT;
+	hb.ttl = NODE_HB_TTL_DEFAULT;
+}
+
+static void node_hb_apply(void) {
+	hb.last_result = gecko_cmd_mesh_test_set_local_heartbeat_publication(
+			hb.destination, NODE_HB_COUNT_LOG, hb.period_log, hb.ttl,
+			NODE_HB_FEATURES, NODE_HB_NETKEY_INDEX)->result;
+	if (hb.last_result) {
+		printf("Heartbeat publication failed 0x%x !!!\r\n", hb.last_result);
+	}
+}
+
+void node_hb_start(uint16 destination) {
+	hb.destination = destination;
+	hb.running = true;
+	node_hb_apply();
+}
+
+void node_hb_set_destination(uint16 destination) {
+	if (destination == hb.destination) {
+		return;
+	}
+	hb.destination = destination;
+	if (hb.running) {
+		node_hb_apply();
+	}
+}
+
+bool node_hb_configure(uint8 period_log, uint8 ttl) {
+	if (period_log == 0 || period_log > NODE_HB_PERIOD_LOG_MAX
+			|| ttl > NODE_HB_TTL_MAX) {
+		return false;
+	}
+	hb.period_log = period_log;
+	hb.ttl = ttl;
+	if (hb.running) {
+		node_hb_apply();
+	}
+	return true;
+}
+
+void node_hb_get_state(node_hb_state_t *state) {
+	*state = hb;
+}
@@ -0,0 +1,40 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_hb.h
+ * Liveness of the friend node through mesh heartbeat publication.
+ ******************************************************************************/
+
+#ifndef NODE_HB_H
+#define NODE_HB_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Period of 2^(log - 1) s, 0x01..0x11 */
+#define NODE_HB_PERIOD_LOG_DEFAULT	0x05
+#define NODE_HB_PERIOD_LOG_MAX		0x11
+#define NODE_HB_TTL_DEFAULT			5
+#define NODE_HB_TTL_MAX				0x7f
+/* Publish until reconfigured */
+#define NODE_HB_COUNT_LOG			0xff
+/* Relay, proxy and friend changes trigger an extra heartbeat */
+#define NODE_HB_FEATURES			0x0007
+#define NODE_HB_NETKEY_INDEX		0
+
+typedef struct {
+	uint16 destination;
+	uint8 period_log;
+	uint8 ttl;
+	bool running;
+	uint16 last_result;
+} node_hb_state_t;
+
+void node_hb_init(void);
+/* Start publishing to the gateway once provisioned */
+void node_hb_start(uint16 destination);
+/* Follow a gateway failover */
+void node_hb_set_destination(uint16 destination);
+bool node_hb_configure(uint8 period_log, uint8 ttl);
+void node_hb_get_state(node_hb_state_t *state);
+
+#endif /* NODE_HB_H */
@@ -0,0 +1,175 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_stats.c
+ * The sampler owns the counters: system and coex counters are read with reset
+ * and the mesh node statistics are cleared after each read, so every read is
+ * already the delta of one period. Other modules use the samples instead of
+ * reading the stack counters themselves.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "mesh_data.h"
+#include "receive_node.h"
+#include "send_queue.h"
+#include "node_stats.h"
+
+/* uint32 counters returned by coex_get_counters */
+#define COEX_LOW_PRI_DENIED		2
+#define COEX_HIGH_PRI_DENIED	3
+
+static node_stats_sample_t stats_ring[NODE_STATS_RING_LEN];
+static uint8 stats_head;	/* next slot to write */
+static uint8 stats_count;
+static node_stats_totals_t stats_totals;
+static uint32 stats_last_ms;
+static bool stats_publish;
+
+static uint32 read_le32(const uint8 *p) {
+	return p[0] | (p[1] << 8) | ((uint32) p[2] << 16) | ((uint32) p[3] << 24);
+}
+
+static uint16 sat16(uint32 v) {
+	return v > 0xffff ? 0xffff : (uint16) v;
+}
+
+void node_stats_init(void) {
+	memset(stats_ring, 0, sizeof(stats_ring));
+	memset(&stats_totals, 0, sizeof(stats_totals));
+	stats_head = 0;
+	stats_count = 0;
+	stats_publish = false;
+	app_timer_register(TIMER_ID_NODE_STATS, node_stats_sample);
+}
+
+void node_stats_start(uint16 period_s) {
+	//Drop whatever piled up before the first period
+	gecko_cmd_system_get_counters(1);
+	gecko_cmd_coex_get_counters(1);
+	gecko_cmd_mesh_node_clear_statistics();
+	stats_last_ms = app_time_ms();
+
+	app_timer_set_lazy(period_s * APP_TIME_TICKS_PER_SEC,
+			APP_TIMER_SLACK(period_s * APP_TIME_TICKS_PER_SEC),
+			TIMER_ID_NODE_STATS, 0);
+}
+
+static void node_stats_read_mesh(node_stats_sample_t *s) {
+	struct gecko_msg_mesh_node_get_statistics_rsp_t *mesh =
+			gecko_cmd_mesh_node_get_statistics();
+	uint32 total = 0;
+	uint8 i;
+
+	if (mesh->result) {
+		return;
+	}
+	for (i = 0; i + 1 < mesh->statistics.len; i += 2) {
+		uint16 word = mesh->statistics.data[i]
+				| (mesh->statistics.data[i + 1] << 8);
+#ifdef NODE_STATS_RELAY_DROP_WORD
+		if (i / 2 == NODE_STATS_RELAY_DROP_WORD) {
+			s->relay_drops = word;
+		}
+#endif
+		total += word;
+	}
+	s->mesh_events = sat16(total);
+	gecko_cmd_mesh_node_clear_statistics();
+}
+
+static void node_stats_read_coex(node_stats_sample_t *s) {
+	struct gecko_msg_coex_get_counters_rsp_t *coex =
+			gecko_cmd_coex_get_counters(1);
+
+	if (coex->result || coex->counters.len < 4 * (COEX_HIGH_PRI_DENIED + 1)) {
+		return;
+	}
+	s->coex_denied = sat16(
+			read_le32(&coex->counters.data[4 * COEX_LOW_PRI_DENIED])
+					+ read_le32(&coex->counters.data[4 * COEX_HIGH_PRI_DENIED]));
+}
+
+static void node_stats_publish(const node_stats_sample_t *s) {
+	uint32 pps = (s->tx_pps_x10 + s->rx_pps_x10) / 10;
+	uint16 message = 0;
+
+	if (s->crc_errors || s->tx_failures || s->coex_denied) {
+		message |= 0x01;
+	}
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	if (s->relay_drops) {
+		message |= 0x01;
+	}
+#endif
+	message |= (NODE_STATS_ADDRESS & 0x7f) << 1;
+	message |= (pps > 0xff ? 0xff : pps) << 8;
+	send_queue_push(SEND_PRIO_PERIODIC, FLAG_NON_RESPONSE, message);
+}
+
+void node_stats_sample(void) {
+	node_stats_sample_t *s = &stats_ring[stats_head];
+	struct gecko_msg_system_get_counters_rsp_t *cnt;
+	uint32 now = app_time_ms();
+	uint32 period = (uint32) (now - stats_last_ms);
+
+	memset(s, 0, sizeof(*s));
+	s->time_ms = now;
+	s->period_ms = sat16(period);
+	stats_last_ms = now;
+	if (period == 0) {
+		period = 1;
+	}
+
+	cnt = gecko_cmd_system_get_counters(1);
+	if (cnt->result == 0) {
+		s->tx_pps_x10 = sat16(cnt->tx_packets * 10000UL / period);
+		s->rx_pps_x10 = sat16(cnt->rx_packets * 10000UL / period);
+		s->crc_errors = cnt->crc_errors;
+		s->tx_failures = cnt->failures;
+		stats_totals.tx_packets += cnt->tx_packets;
+		stats_totals.rx_packets += cnt->rx_packets;
+	}
+	node_stats_read_coex(s);
+	node_stats_read_mesh(s);
+
+	stats_totals.crc_errors += s->crc_errors;
+	stats_totals.tx_failures += s->tx_failures;
+	stats_totals.coex_denied += s->coex_denied;
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	stats_totals.relay_drops += s->relay_drops;
+#endif
+
+	stats_head = (stats_head + 1) & (NODE_STATS_RING_LEN - 1);
+	if (stats_count < NODE_STATS_RING_LEN) {
+		stats_count++;
+	}
+
+	if (stats_publish) {
+		node_stats_publish(s);
+	}
+}
+
+uint8 node_stats_count(void) {
+	return stats_count;
+}
+
+bool node_stats_get(uint8 age, node_stats_sample_t *sample) {
+	if (age >= stats_count) {
+		return false;
+	}
+	*sample = stats_ring[(stats_head - 1 - age) & (NODE_STATS_RING_LEN - 1)];
+	return true;
+}
+
+void node_stats_get_totals(node_stats_totals_t *totals) {
+	*totals = stats_totals;
+}
+
+void node_stats_set_publish(bool publish) {
+	stats_publish = publish;
+}
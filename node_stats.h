@@ -0,0 +1,63 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_stats.h
+ * Periodic sampler of the stack radio, coex and mesh node counters.
+ ******************************************************************************/
+
+#ifndef NODE_STATS_H
+#define NODE_STATS_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#define NODE_STATS_PERIOD_S			10
+/* Samples kept for trend queries, must be a power of two */
+#define NODE_STATS_RING_LEN			16
+
+/* 16 bit word of the mesh node statistics holding relay drops. The layout
+ * depends on the linked stack version and is not documented for the one in
+ * this tree, so relay drops are only sampled and published when the build
+ * defines the word; a constant zero would read as measured. */
+/* #define NODE_STATS_RELAY_DROP_WORD	n */
+
+#define TIMER_ID_NODE_STATS			83
+
+typedef struct {
+	uint32 time_ms;		/* end of the sample period */
+	uint16 period_ms;
+	uint16 tx_pps_x10;	/* radio packets per second, times 10 */
+	uint16 rx_pps_x10;
+	uint16 crc_errors;	/* counts within the period */
+	uint16 tx_failures;
+	uint16 coex_denied;
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	uint16 relay_drops;
+#endif
+	uint16 mesh_events;	/* growth of all mesh node statistics counters */
+} node_stats_sample_t;
+
+typedef struct {
+	uint32 tx_packets;
+	uint32 rx_packets;
+	uint32 crc_errors;
+	uint32 tx_failures;
+	uint32 coex_denied;
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	uint32 relay_drops;
+#endif
+} node_stats_totals_t;
+
+void node_stats_init(void);
+void node_stats_start(uint16 period_s);
+/* TIMER_ID_NODE_STATS handler */
+void node_stats_sample(void);
+
+uint8 node_stats_count(void);
+/* age 0 is the latest sample */
+bool node_stats_get(uint8 age, node_stats_sample_t *sample);
+void node_stats_get_totals(node_stats_totals_t *totals);
+
+/* Send each sample to the gateway as a NODE_STATS_ADDRESS record */
+void node_stats_set_publish(bool publish);
+
+#endif /* NODE_STATS_H */
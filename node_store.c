@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_store.c
+ * Writes are coalesced behind a single shot timer and spaced by at least
+ * NODE_STORE_MIN_INTERVAL_S, a snapshot equal to the stored one is not
+ * written at all.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "node_store.h"
+
+static node_store_fill_fn store_fill;
+static node_store_stats_t stats;
+static node_snapshot_t stored;
+static bool stored_valid;
+static bool timer_armed;
+static bool written_once;
+static uint32 last_write_ms;
+
+void node_store_init(node_store_fill_fn fill) {
+	store_fill = fill;
+	memset(&stats, 0, sizeof(stats));
+	stored_valid = false;
+	timer_armed = false;
+	written_once = false;
+	app_timer_register(TIMER_ID_NODE_STORE, node_store_on_timer);
+}
+
+bool node_store_load(node_snapshot_t *snap) {
+	struct gecko_msg_flash_ps_load_rsp_t *ps = gecko_cmd_flash_ps_load(
+	NODE_STORE_PS_KEY);
+
+	if (ps->result || ps->value.len != sizeof(node_snapshot_t)) {
+		return false;
+	}
+	memcpy(snap, ps->value.data, sizeof(node_snapshot_t));
+	if (snap->version != NODE_STORE_VERSION
+			|| snap->num_lpn > NODE_STORE_MAX_LPN) {
+		return false;
+	}
+	stored = *snap;
+	stored_valid = true;
+	return true;
+}
+
+static void node_store_arm(uint32 delay_s) {
+	app_timer_set_lazy(delay_s * APP_TIME_TICKS_PER_SEC,
+			APP_TIMER_SLACK(delay_s * APP_TIME_TICKS_PER_SEC),
+			TIMER_ID_NODE_STORE, 1);
+	timer_armed = true;
+}
+
+void node_store_mark_dirty(void) {
+	stats.dirty = true;
+	if (!timer_armed) {
+		node_store_arm(NODE_STORE_COALESCE_S);
+	}
+}
+
+void node_store_flush(void) {
+	node_snapshot_t snap;
+	uint16 result;
+
+	if (!stats.dirty || store_fill == NULL) {
+		return;
+	}
+	stats.dirty = false;
+
+	memset(&snap, 0, sizeof(snap));
+	store_fill(&snap);
+	snap.version = NODE_STORE_VERSION;
+	if (stored_valid && memcmp(&snap, &stored, sizeof(snap)) == 0) {
+		stats.unchanged++;
+		return;
+	}
+
+	result = gecko_cmd_flash_ps_save(NODE_STORE_PS_KEY, sizeof(snap),
+			(const uint8 *) &snap)->result;
+	if (result) {
+		printf("Node store save failed 0x%x !!!\r\n", result);
+		stats.failures++;
+		return;
+	}
+	stored = snap;
+	stored_valid = true;
+	written_once = true;
+	last_write_ms = app_time_ms();
+	stats.writes++;
+}
+
+void node_store_on_timer(void) {
+	uint32 since_s = (app_time_ms() - last_write_ms) / 1000;
+
+	timer_armed = false;
+	if (!stats.dirty) {
+		return;
+	}
+	if (written_once && since_s < NODE_STORE_MIN_INTERVAL_S) {
+		node_store_arm(NODE_STORE_MIN_INTERVAL_S - since_s);
+		return;
+	}
+	node_store_flush();
+}
+
+void node_store_get_stats(node_store_stats_t *out) {
+	*out = stats;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief node_store.h
+ * Snapshot of the LPN table and gateway state kept in a PS key.
+ ******************************************************************************/
+
+#ifndef NODE_STORE_H
+#define NODE_STORE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "mesh_app_memory_config.h"
+
+/* Bump when node_snapshot_t changes, older snapshots are ignored */
+#define NODE_STORE_VERSION			2
+#define NODE_STORE_PS_KEY			0x4012
+/* PS values are limited to 56 bytes, node_snapshot_t must stay below */
+#define NODE_STORE_PS_MAX			56
+#define NODE_STORE_MAX_LPN			MESH_CFG_MAX_FRIENDSHIPS
+
+/* A change is written after this delay so bursts cost a single write */
+#define NODE_STORE_COALESCE_S		10
+/* Flash wear bound: never two writes closer than this */
+#define NODE_STORE_MIN_INTERVAL_S	120
+
+#define TIMER_ID_NODE_STORE			87
+
+typedef struct {
+	uint8 version;
+	uint8 num_lpn;
+	uint8 gateway_time_out;	/* heartbeat windows the gateway was missed */
+	uint8 sched_enabled;	/* report interval adaptation */
+	uint16 lpn_message[NODE_STORE_MAX_LPN];	/* level message encoding */
+	uint8 lpn_time_out[NODE_STORE_MAX_LPN];
+	uint16 gateway_address;
+	uint16 report_interval;
+	uint16 report_min_s;
+	uint16 report_max_s;
+	/* Settings a gateway can change through the vendor model */
+	uint16 alarm_window_ms;
+	uint16 sensor_cadence_s;
+	uint16 sync_interval_s;
+	uint8 hb_period_log;
+	uint8 hb_ttl;
+} node_snapshot_t;
+
+/* C99 has no static assert: the array size goes negative when the snapshot
+ * outgrows a PS value, e.g. after raising MESH_CFG_MAX_FRIENDSHIPS */
+typedef char node_snapshot_fits_ps[
+		sizeof(node_snapshot_t) <= NODE_STORE_PS_MAX ? 1 : -1];
+
+typedef struct {
+	uint32 writes;
+	uint32 unchanged;	/* flushes skipped because nothing differed */
+	uint32 failures;
+	bool dirty;
+} node_store_stats_t;
+
+/* Fills a snapshot from the live state when a write is due */
+typedef void (*node_store_fill_fn)(node_snapshot_t *snap);
+
+void node_store_init(node_store_fill_fn fill);
+/* Read the stored snapshot, false if there is none or it is outdated */
+bool node_store_load(node_snapshot_t *snap);
+/* Schedule a coalesced write of the current state */
+void node_store_mark_dirty(void);
+/* Write now if dirty, ignoring the wear interval */
+void node_store_flush(void);
+/* TIMER_ID_NODE_STORE handler */
+void node_store_on_timer(void);
+void node_store_get_stats(node_store_stats_t *stats);
+
+#endif /* NODE_STORE_H */
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file
+ * @brief prof.c
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "prof.h"
+
+#if APP_PROFILE
+
+static prof_stats_t probes[PROF_COUNT];
+
+static const char *probe_names[PROF_COUNT] = { "handle_gecko_event",
+		"pri_level_request", "send_mesh_data", "deserialize_request",
+		"LCD_flush", "graphWriteString", };
+
+void prof_init(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	prof_clear();
+}
+
+void prof_clear(void) {
+	uint8 i;
+
+	memset(probes, 0, sizeof(probes));
+	for (i = 0; i < PROF_COUNT; i++) {
+		probes[i].min = 0xffffffff;
+	}
+}
+
+void prof_record(uint8 probe, uint32 cycles) {
+	prof_stats_t *p = &probes[probe];
+	uint8 bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+
+	if (bucket >= PROF_BUCKETS) {
+		bucket = PROF_BUCKETS - 1;
+	}
+	p->count++;
+	if (cycles < p->min) {
+		p->min = cycles;
+	}
+	if (cycles > p->max) {
+		p->max = cycles;
+	}
+	p->total += cycles;
+	if (p->hist[bucket] != 0xffff) {
+		p->hist[bucket]++;
+	}
+}
+
+bool prof_get(uint8 probe, prof_stats_t *stats) {
+	if (probe >= PROF_COUNT) {
+		return false;
+	}
+	*stats = probes[probe];
+	return true;
+}
+
+const char *prof_name(uint8 probe) {
+	return probe < PROF_COUNT ? probe_names[probe] : "?";
+}
+
+#endif /* APP_PROFILE */
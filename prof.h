@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief prof.h
+ * Cycle count profiling of hot functions on the DWT cycle counter.
+ * Build with -DAPP_PROFILE=1, otherwise every macro expands to nothing.
+ ******************************************************************************/
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bg_types.h"
+
+#ifndef APP_PROFILE
+#define APP_PROFILE			0
+#endif
+
+/* Histogram bucket n counts calls of 2^n up to 2^(n+1) - 1 cycles */
+#define PROF_BUCKETS		24
+
+typedef enum {
+	PROF_HANDLE_EVENT,
+	PROF_PRI_LEVEL_REQUEST,
+	PROF_SEND_MESH_DATA,
+	PROF_DESERIALIZE,
+	PROF_LCD_FLUSH,
+	PROF_GRAPH_WRITE,
+	PROF_COUNT,
+} prof_probe_t;
+
+typedef struct {
+	uint32 count;
+	uint32 min;			/* cycles */
+	uint32 max;
+	uint64_t total;
+	uint16 hist[PROF_BUCKETS];	/* saturates at 0xffff */
+} prof_stats_t;
+
+#if APP_PROFILE
+
+#include "em_device.h"
+
+typedef struct {
+	uint8 probe;
+	uint32 start;
+} prof_scope_t;
+
+void prof_init(void);
+void prof_clear(void);
+void prof_record(uint8 probe, uint32 cycles);
+bool prof_get(uint8 probe, prof_stats_t *stats);
+const char *prof_name(uint8 probe);
+
+static inline void prof_scope_end(prof_scope_t *scope) {
+	prof_record(scope->probe, DWT->CYCCNT - scope->start);
+}
+
+/* Times the rest of the enclosing block, whichever way it is left. Interrupts
+ * taken meanwhile are included. */
+#define PROF_SCOPE(probe) \
+	prof_scope_t prof_scope_##probe __attribute__((cleanup(prof_scope_end))) \
+			= { probe, DWT->CYCCNT }
+
+#else
+
+#define prof_init()
+#define prof_clear()
+#define PROF_SCOPE(probe)
+
+#endif /* APP_PROFILE */
+
+#endif /* PROF_H */
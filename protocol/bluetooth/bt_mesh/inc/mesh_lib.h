@@ -261,6 +261,111 @@ mesh_lib_generic_server_register_handler(uint16_t model_id,
 		uint16_t element_index, mesh_lib_generic_server_client_request_cb cb,
 		mesh_lib_generic_server_change_cb ch);
 
+/**
+ * @brief Undecoded client request
+ *
+ * Refers to the event being processed and is only valid during the
+ * callback. Fields are read from the message on demand with the
+ * mesh_lib_request_view_*() accessors.
+ */
+struct mesh_lib_request_view {
+	const struct gecko_msg_mesh_generic_server_client_request_evt_t *evt;
+};
+
+/**
+ * @brief Undecoded server state change
+ *
+ * Refers to the event being processed and is only valid during the
+ * callback; see mesh_lib_state_view_decode().
+ */
+struct mesh_lib_state_view {
+	const struct gecko_msg_mesh_generic_server_state_changed_evt_t *evt;
+};
+
+/**
+ * @brief Client request handler function taking the undecoded request
+ *
+ * @param view Request, with the event fields in view->evt
+ */
+typedef void
+(*mesh_lib_generic_server_raw_request_cb)(
+		const struct mesh_lib_request_view *view);
+
+/**
+ * @brief Server state change handler function taking the undecoded state
+ *
+ * @param view State change, with the event fields in view->evt
+ */
+typedef void
+(*mesh_lib_generic_server_raw_change_cb)(
+		const struct mesh_lib_state_view *view);
+
+/**
+ * @brief Register undecoded handler functions for a server model
+ *
+ * Like mesh_lib_generic_server_register_handler(), except that
+ * mesh_lib_generic_server_event_handler() passes the events without
+ * deserializing them; the handler decodes what it needs. Either
+ * function may be NULL to ignore the corresponding events.
+ *
+ * @param model_id Model for which functions are being registered
+ * @param element_index Element where the model resides
+ * @param cb Function for client requests
+ * @param ch Function for server state changes
+ *
+ * @return bg_err_success if registration succeeded; an error otherwise
+ */
+errorcode_t
+mesh_lib_generic_server_register_raw_handler(uint16_t model_id,
+		uint16_t element_index, mesh_lib_generic_server_raw_request_cb cb,
+		mesh_lib_generic_server_raw_change_cb ch);
+
+/**
+ * @brief Kind of a client request, without decoding it
+ */
+static inline mesh_generic_request_t
+mesh_lib_request_view_kind(const struct mesh_lib_request_view *view)
+{
+	return (mesh_generic_request_t) view->evt->type;
+}
+
+/**
+ * @brief Level of a level, level move or level halt request
+ *
+ * @param view Request
+ * @param level Level read from the message
+ *
+ * @return 0 on success; -1 if the request carries no level
+ */
+int mesh_lib_request_view_level(const struct mesh_lib_request_view *view,
+		int16_t *level);
+
+/**
+ * @brief Decode the whole request
+ *
+ * @param view Request
+ * @param req Decoded request
+ *
+ * @return 0 on success; -1 if the message is malformed
+ */
+int mesh_lib_request_view_decode(const struct mesh_lib_request_view *view,
+		struct mesh_generic_request *req);
+
+/**
+ * @brief Decode the current and target state of a state change
+ *
+ * @param view State change
+ * @param current Current model state
+ * @param target Target model state
+ * @param has_target Set to nonzero if a transition is ongoing and
+ * target holds its target state
+ *
+ * @return 0 on success; -1 if the message is malformed
+ */
+int mesh_lib_state_view_decode(const struct mesh_lib_state_view *view,
+		struct mesh_generic_state *current, struct mesh_generic_state *target,
+		int *has_target);
+
 /***
  *** Generic Client
  ***/
@@ -51,6 +51,9 @@ struct reg {
 		struct {
 			mesh_lib_generic_server_client_request_cb client_request_cb;
 			mesh_lib_generic_server_change_cb state_changed_cb;
+			/* Set instead of the above for undecoded handlers */
+			mesh_lib_generic_server_raw_request_cb raw_request_cb;
+			mesh_lib_generic_server_raw_change_cb raw_change_cb;
 		} server;
 		struct {
 			mesh_lib_generic_client_server_response_cb server_response_cb;
@@ -131,6 +134,59 @@ errorcode_t mesh_lib_generic_server_register_handler(uint16_t model_id,
 	return bg_err_success;
 }
 
+errorcode_t mesh_lib_generic_server_register_raw_handler(uint16_t model_id,
+		uint16_t elem_index, mesh_lib_generic_server_raw_request_cb cb,
+		mesh_lib_generic_server_raw_change_cb ch) {
+	struct reg *reg = NULL;
+
+	reg = find_reg(model_id, elem_index);
+	if (reg) {
+		return bg_err_wrong_state; // already exists
+	}
+
+	reg = find_free();
+	if (!reg) {
+		return bg_err_out_of_memory;
+	}
+
+	reg->model_id = model_id;
+	reg->elem_index = elem_index;
+	reg->server.raw_request_cb = cb;
+	reg->server.raw_change_cb = ch;
+	return bg_err_success;
+}
+
+int mesh_lib_request_view_level(const struct mesh_lib_request_view *view,
+		int16_t *level) {
+	switch (view->evt->type) {
+	case mesh_generic_request_level:
+	case mesh_generic_request_level_move:
+	case mesh_generic_request_level_halt:
+		if (view->evt->parameters.len != 2) {
+			return -1;
+		}
+		*level = (int16_t) (view->evt->parameters.data[0]
+				| (view->evt->parameters.data[1] << 8));
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int mesh_lib_request_view_decode(const struct mesh_lib_request_view *view,
+		struct mesh_generic_request *req) {
+	return mesh_lib_deserialize_request(req, view->evt->type,
+			view->evt->parameters.data, view->evt->parameters.len);
+}
+
+int mesh_lib_state_view_decode(const struct mesh_lib_state_view *view,
+		struct mesh_generic_state *current, struct mesh_generic_state *target,
+		int *has_target) {
+	return mesh_lib_deserialize_state(current, target, has_target,
+			view->evt->type, view->evt->parameters.data,
+			view->evt->parameters.len);
+}
+
 errorcode_t mesh_lib_generic_client_register_handler(uint16_t model_id,
 		uint16_t elem_index, mesh_lib_generic_client_server_response_cb cb) {
 	struct reg *reg = NULL;
@@ -169,7 +225,11 @@ void mesh_lib_generic_server_event_handler(struct gecko_cmd_packet *evt) {
 		req = &(evt->data.evt_mesh_generic_server_client_request);
 		reg = find_reg(req->model_id, req->elem_index);
 
-		if (reg) {
+		if (reg && reg->server.raw_request_cb) {
+			struct mesh_lib_request_view view = { req };
+
+			(reg->server.raw_request_cb)(&view);
+		} else if (reg && reg->server.client_request_cb) {
 			if (mesh_lib_deserialize_request(&request, req->type,
 					req->parameters.data, req->parameters.len) == 0) {
 				(reg->server.client_request_cb)(req->model_id, req->elem_index,
@@ -182,7 +242,11 @@ void mesh_lib_generic_server_event_handler(struct gecko_cmd_packet *evt) {
 	case gecko_evt_mesh_generic_server_state_changed_id:
 		chg = &(evt->data.evt_mesh_generic_server_state_changed);
 		reg = find_reg(chg->model_id, chg->elem_index);
-		if (reg) {
+		if (reg && reg->server.raw_change_cb) {
+			struct mesh_lib_state_view view = { chg };
+
+			(reg->server.raw_change_cb)(&view);
+		} else if (reg && reg->server.state_changed_cb) {
 			if (mesh_lib_deserialize_state(&current, &target, &has_target,
 					chg->type, chg->parameters.data, chg->parameters.len)
 					== 0) {
@@ -25,6 +25,7 @@
 
 #include "mesh_generic_model_capi_types.h"
 #include "mesh_serdeser.h"
+#include "prof.h"
 
 static int16_t int16_from_buf(const uint8_t *ptr) {
 	return ((int16_t) ptr[0]) | ((int16_t) ptr[1] << 8);
@@ -258,6 +259,7 @@ int mesh_lib_serialize_request(const struct mesh_generic_request *req,
 int mesh_lib_deserialize_request(struct mesh_generic_request *req,
 		mesh_generic_request_t kind, const uint8_t *msg_buf, size_t msg_len) {
 	size_t msg_off = 0;
+	PROF_SCOPE(PROF_DESERIALIZE);
 
 	switch (kind) {
 	case mesh_generic_request_on_off:
@@ -0,0 +1,38 @@
+/***************************************************************************//**
+ * @file
+ * @brief receive_node.h
+ * Application level API of the friend (receive) node implemented in main.c
+ ******************************************************************************/
+
+#ifndef RECEIVE_NODE_H
+#define RECEIVE_NODE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Bounds of the gateway report interval, in seconds */
+#define REPORT_INTERVAL_DEFAULT		15
+#define REPORT_INTERVAL_MIN			1
+#define REPORT_INTERVAL_MAX			3600
+
+/* Define Response flag when send Mesh data */
+#define FLAG_NON_RESPONSE          0x00
+#define FLAG_RESPONSE              0x01
+/* Define Retransmit flag */
+#define FLAG_RETRANS               0x01
+#define FLAG_NON_RETRANS           0x00
+
+/* Application key of all messages to the gateway */
+#define APP_KEY_INDEX	0
+
+void receive_node_init();
+uint16 send_mesh_data(uint8 response_flag, uint8 retransmit, uint16 message);
+/* Report the node and its LPNs, the changed LPN entries at state priority */
+void send_data_array2gateway(uint32 changed);
+
+uint16 receive_node_get_report_interval(void);
+bool receive_node_set_report_interval(uint16 seconds);
+/* Battery of the friend node itself, for its own report record */
+uint8 receive_node_battery_percent(void);
+
+#endif /* RECEIVE_NODE_H */
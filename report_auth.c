@@ -0,0 +1,291 @@
+/***************************************************************************//**
+ * @file
+ * @brief report_auth.c
+ * CCM is built from the CBC and CTR modes of the CRYPTO peripheral, which
+ * process the formatted blocks without the CPU doing any AES rounds. The
+ * stack drives CRYPTO0, this module keeps to CRYPTO1.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_crypto.h"
+#include "native_gecko.h"
+
+#include "receive_node.h"
+#include "send_queue.h"
+#include "report_auth.h"
+
+#define AUTH_CRYPTO			CRYPTO1
+#define AUTH_CRYPTO_CLOCK	cmuClock_CRYPTO1
+
+#define CCM_BLOCK			16
+/* Bytes of the length field, leaves a 13 byte nonce */
+#define CCM_L				2
+/* B0, the associated data length field and two paddings */
+#define CCM_BUF_LEN			(REPORT_AUTH_MAX_LEN + 3 * CCM_BLOCK)
+
+static report_auth_state_t auth;
+static uint8 auth_key[REPORT_AUTH_KEY_LEN];
+static uint32 counter_reserved;
+
+static uint8 ccm_buf[CCM_BUF_LEN];
+static uint8 ctr_buf[REPORT_AUTH_MAX_LEN + CCM_BLOCK];
+
+static uint8 report_aad[REPORT_AUTH_MAX_LEN];
+static uint16 report_aad_len;
+static uint16 report_src;
+static bool report_open;
+
+void report_auth_init(void) {
+	memset(&auth, 0, sizeof(auth));
+	memset(auth_key, 0, sizeof(auth_key));
+	counter_reserved = 0;
+	report_open = false;
+	CMU_ClockEnable(AUTH_CRYPTO_CLOCK, true);
+}
+
+void report_auth_start(void) {
+	struct gecko_msg_flash_ps_load_rsp_t *ps;
+
+	ps = gecko_cmd_flash_ps_load(REPORT_AUTH_PS_KEY);
+	auth.key_present = ps->result == 0
+			&& ps->value.len == REPORT_AUTH_KEY_LEN;
+	if (auth.key_present) {
+		memcpy(auth_key, ps->value.data, REPORT_AUTH_KEY_LEN);
+	}
+	auth.enabled = auth.key_present;
+
+	ps = gecko_cmd_flash_ps_load(REPORT_AUTH_PS_COUNTER);
+	if (ps->result == 0 && ps->value.len == 4) {
+		auth.frame_counter = ps->value.data[0]
+				| ((uint32) ps->value.data[1] << 8)
+				| ((uint32) ps->value.data[2] << 16)
+				| ((uint32) ps->value.data[3] << 24);
+	}
+	//Counters below the stored reservation may have been used before reset
+	counter_reserved = auth.frame_counter;
+
+	if (auth.key_present) {
+		printf("Report authentication on, counter %lu\r\n",
+				(unsigned long) auth.frame_counter);
+	}
+}
+
+/* Make sure the frame counter never repeats across resets */
+static bool counter_reserve(void) {
+	uint32 next;
+	uint8 buf[4];
+	uint16 result;
+
+	if (auth.frame_counter < counter_reserved) {
+		return true;
+	}
+	next = auth.frame_counter + REPORT_AUTH_COUNTER_RESERVE;
+	buf[0] = next & 0xff;
+	buf[1] = (next >> 8) & 0xff;
+	buf[2] = (next >> 16) & 0xff;
+	buf[3] = next >> 24;
+	result = gecko_cmd_flash_ps_save(REPORT_AUTH_PS_COUNTER, sizeof(buf),
+			buf)->result;
+	if (result) {
+		printf("Auth counter save failed 0x%x !!!\r\n", result);
+		return false;
+	}
+	counter_reserved = next;
+	return true;
+}
+
+bool report_auth_set_key(const uint8 *key) {
+	uint16 result = gecko_cmd_flash_ps_save(REPORT_AUTH_PS_KEY,
+			REPORT_AUTH_KEY_LEN, key)->result;
+
+	if (result) {
+		printf("Auth key save failed 0x%x !!!\r\n", result);
+		return false;
+	}
+	memcpy(auth_key, key, REPORT_AUTH_KEY_LEN);
+	auth.key_present = true;
+	auth.enabled = true;
+	return true;
+}
+
+void report_auth_clear_key(void) {
+	gecko_cmd_flash_ps_erase(REPORT_AUTH_PS_KEY);
+	memset(auth_key, 0, sizeof(auth_key));
+	auth.key_present = false;
+	auth.enabled = false;
+}
+
+void report_auth_enable(bool enable) {
+	auth.enabled = enable && auth.key_present;
+}
+
+void report_auth_get_state(report_auth_state_t *state) {
+	*state = auth;
+}
+
+static uint16 ccm_pad(uint16 len) {
+	return (len + CCM_BLOCK - 1) & ~(CCM_BLOCK - 1);
+}
+
+/* B0 and the counter blocks share the layout flags, nonce, 16 bit value */
+static void ccm_block(uint8 *b, uint8 flags, const uint8 *nonce, uint16 value) {
+	b[0] = flags;
+	memcpy(&b[1], nonce, REPORT_AUTH_NONCE_LEN);
+	b[14] = value >> 8;
+	b[15] = value & 0xff;
+}
+
+/* CBC-MAC over B0, the associated data and the payload */
+static void ccm_mac(const uint8 *nonce, const uint8 *aad, uint16 aad_len,
+		const uint8 *msg, uint16 len, uint8 *mac) {
+	static const uint8 zero_iv[CCM_BLOCK];
+	uint16 pos = CCM_BLOCK;
+
+	memset(ccm_buf, 0, sizeof(ccm_buf));
+	ccm_block(ccm_buf, (aad_len ? 0x40 : 0)
+			| (((REPORT_AUTH_TAG_LEN - 2) / 2) << 3) | (CCM_L - 1), nonce, len);
+	if (aad_len) {
+		ccm_buf[pos] = aad_len >> 8;
+		ccm_buf[pos + 1] = aad_len & 0xff;
+		memcpy(&ccm_buf[pos + 2], aad, aad_len);
+		pos += ccm_pad(2 + aad_len);
+	}
+	if (len) {
+		memcpy(&ccm_buf[pos], msg, len);
+		pos += ccm_pad(len);
+	}
+	CRYPTO_AES_CBC128(AUTH_CRYPTO, ccm_buf, ccm_buf, pos, auth_key, zero_iv,
+			true);
+	memcpy(mac, &ccm_buf[pos - CCM_BLOCK], REPORT_AUTH_TAG_LEN);
+}
+
+/* Key stream from counter block 1 over the payload, S0 for the tag */
+static void ccm_ctr(const uint8 *nonce, const uint8 *in, uint8 *out,
+		uint16 len, uint8 *s0) {
+	uint8 ctr[CCM_BLOCK];
+
+	ccm_block(ctr, CCM_L - 1, nonce, 0);
+	CRYPTO_AES_ECB128(AUTH_CRYPTO, s0, ctr, CCM_BLOCK, auth_key, true);
+	if (len == 0) {
+		return;
+	}
+	memset(ctr_buf, 0, sizeof(ctr_buf));
+	memcpy(ctr_buf, in, len);
+	ctr[15] = 1;
+	CRYPTO_AES_CTR128(AUTH_CRYPTO, ctr_buf, ctr_buf, ccm_pad(len), auth_key,
+			ctr, CRYPTO_AES_CTRUpdate32Bit);
+	memcpy(out, ctr_buf, len);
+}
+
+bool report_auth_ccm(bool encrypt, const uint8 *nonce, const uint8 *aad,
+		uint16 aad_len, const uint8 *in, uint8 *out, uint16 len, uint8 *tag) {
+	uint8 mac[REPORT_AUTH_TAG_LEN];
+	uint8 s0[CCM_BLOCK];
+	uint8 diff = 0;
+	uint8 i;
+
+	if (aad_len + len > REPORT_AUTH_MAX_LEN) {
+		return false;
+	}
+	if (encrypt) {
+		ccm_mac(nonce, aad, aad_len, in, len, mac);
+		ccm_ctr(nonce, in, out, len, s0);
+		for (i = 0; i < REPORT_AUTH_TAG_LEN; i++) {
+			tag[i] = mac[i] ^ s0[i];
+		}
+		return true;
+	}
+	ccm_ctr(nonce, in, out, len, s0);
+	ccm_mac(nonce, aad, aad_len, out, len, mac);
+	for (i = 0; i < REPORT_AUTH_TAG_LEN; i++) {
+		diff |= mac[i] ^ s0[i] ^ tag[i];
+	}
+	return diff == 0;
+}
+
+void report_auth_begin(uint16 src) {
+	report_src = src;
+	report_aad_len = 0;
+	report_open = auth.enabled;
+}
+
+void report_auth_add(uint16 message) {
+	if (!report_open) {
+		return;
+	}
+	if (report_aad_len + 2 > REPORT_AUTH_MAX_LEN) {
+		auth.overflows++;
+		report_open = false;
+		return;
+	}
+	report_aad[report_aad_len++] = message & 0xff;
+	report_aad[report_aad_len++] = message >> 8;
+}
+
+static uint16 auth_record(uint8 flag, uint8 value) {
+	return flag | ((REPORT_AUTH_ADDRESS & 0x7f) << 1) | ((uint16) value << 8);
+}
+
+uint8 report_auth_seal(uint16 *trailer) {
+	uint8 nonce[REPORT_AUTH_NONCE_LEN];
+	uint8 tag[REPORT_AUTH_TAG_LEN];
+	uint8 i;
+
+	if (!report_open) {
+		return 0;
+	}
+	report_open = false;
+	if (!counter_reserve()) {
+		return 0;
+	}
+
+	memset(nonce, 0, sizeof(nonce));
+	nonce[0] = report_src >> 8;
+	nonce[1] = report_src & 0xff;
+	nonce[2] = auth.frame_counter >> 24;
+	nonce[3] = (auth.frame_counter >> 16) & 0xff;
+	nonce[4] = (auth.frame_counter >> 8) & 0xff;
+	nonce[5] = auth.frame_counter & 0xff;
+	report_auth_ccm(true, nonce, report_aad, report_aad_len, NULL, NULL, 0,
+			tag);
+
+	trailer[0] = auth_record(1, auth.frame_counter & 0xff);
+	for (i = 0; i < REPORT_AUTH_TAG_LEN; i++) {
+		trailer[1 + i] = auth_record(0, tag[i]);
+	}
+	auth.frame_counter++;
+	auth.reports++;
+	return REPORT_AUTH_TRAILER_LEN;
+}
+
+void report_auth_finish(void) {
+	uint16 trailer[REPORT_AUTH_TRAILER_LEN];
+	uint8 count = report_auth_seal(trailer);
+	uint8 i;
+
+	for (i = 0; i < count; i++) {
+		send_queue_push(SEND_PRIO_PERIODIC, FLAG_NON_RESPONSE, trailer[i]);
+	}
+}
+
+uint32 report_auth_bench(uint16 len) {
+	static uint8 bench_buf[REPORT_AUTH_MAX_LEN];
+	uint8 nonce[REPORT_AUTH_NONCE_LEN];
+	uint8 tag[REPORT_AUTH_TAG_LEN];
+	uint32 start;
+
+	if (len > REPORT_AUTH_MAX_LEN) {
+		len = REPORT_AUTH_MAX_LEN;
+	}
+	memset(nonce, 0, sizeof(nonce));
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	start = DWT->CYCCNT;
+	report_auth_ccm(true, nonce, NULL, 0, bench_buf, bench_buf, len, tag);
+	return DWT->CYCCNT - start;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************//**
+ * @file
+ * @brief report_auth.h
+ * AES-CCM authentication of the reports sent to the gateway.
+ ******************************************************************************/
+
+#ifndef REPORT_AUTH_H
+#define REPORT_AUTH_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* A report is followed by records with this address field: bit 0 set
+ * carries the low byte of the frame counter, then bit 0 clear carries the
+ * tag bytes in order, both in bits 8..15. The tag covers the records of the
+ * report in the order they were added, the nonce holds the node address and
+ * the 32 bit frame counter. */
+#define REPORT_AUTH_ADDRESS		0x7d
+
+#define REPORT_AUTH_KEY_LEN		16
+#define REPORT_AUTH_NONCE_LEN	13
+#define REPORT_AUTH_TAG_LEN		4
+/* Counter record plus one record per tag byte */
+#define REPORT_AUTH_TRAILER_LEN	(1 + REPORT_AUTH_TAG_LEN)
+/* Associated data plus payload of one CCM operation */
+#define REPORT_AUTH_MAX_LEN		128
+
+/* PS keys of the 128 bit key and of the frame counter reservation */
+#define REPORT_AUTH_PS_KEY		0x4010
+#define REPORT_AUTH_PS_COUNTER	0x4011
+/* Frame counters reserved per flash write */
+#define REPORT_AUTH_COUNTER_RESERVE	256
+
+typedef struct {
+	bool key_present;
+	bool enabled;
+	uint32 frame_counter;
+	uint32 reports;
+	uint32 overflows;	/* reports too long to authenticate */
+} report_auth_state_t;
+
+void report_auth_init(void);
+/* Load the key and frame counter from PS, authentication is on with a key */
+void report_auth_start(void);
+bool report_auth_set_key(const uint8 *key);
+void report_auth_clear_key(void);
+void report_auth_enable(bool enable);
+void report_auth_get_state(report_auth_state_t *state);
+
+/* CCM with REPORT_AUTH_TAG_LEN tag and 2 byte length field. Encrypting
+ * writes the tag, decrypting checks it and returns false on mismatch. in and
+ * out may be the same buffer. */
+bool report_auth_ccm(bool encrypt, const uint8 *nonce, const uint8 *aad,
+		uint16 aad_len, const uint8 *in, uint8 *out, uint16 len, uint8 *tag);
+
+/* Authenticate the records of one report: begin, add each record as it is
+ * queued, then finish queues the counter and tag records */
+void report_auth_begin(uint16 src);
+void report_auth_add(uint16 message);
+void report_auth_finish(void);
+/* Like report_auth_finish but returns the records instead of queuing them,
+ * 0 or REPORT_AUTH_TRAILER_LEN of them */
+uint8 report_auth_seal(uint16 *trailer);
+
+/* Encrypt len bytes once, returns the CPU cycles it took */
+uint32 report_auth_bench(uint16 len);
+
+#endif /* REPORT_AUTH_H */
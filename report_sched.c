@@ -0,0 +1,109 @@
+/***************************************************************************//**
+ * @file
+ * @brief report_sched.c
+ * Every report tick the period is re-evaluated:
+ *  - alarms since the last tick: drop to the lower bound
+ *  - network congested: double the period
+ *  - LPN records changed: halve the period
+ *  - nothing happened: stretch the period by a quarter
+ * Congestion is seen as refused or backlogged sends in the send queue, or as
+ * fast growth of the mesh node statistics counters in the last node_stats
+ * sample.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "node_stats.h"
+#include "receive_node.h"
+#include "send_queue.h"
+#include "report_sched.h"
+
+static report_sched_state_t sched;
+
+static uint32 last_send_failed;
+
+static bool report_sched_congested(void) {
+	send_queue_stats_t sq;
+	node_stats_sample_t sample;
+	bool busy = false;
+
+	if (node_stats_get(0, &sample) && sample.period_ms
+			&& (uint32) sample.mesh_events * 1000 / sample.period_ms
+					>= REPORT_SCHED_BUSY_PER_SEC) {
+		busy = true;
+	}
+
+	send_queue_get_stats(&sq);
+	if (sq.failed != last_send_failed || sq.pending[SEND_PRIO_PERIODIC]) {
+		busy = true;
+	}
+	last_send_failed = sq.failed;
+
+	return busy;
+}
+
+void report_sched_init(void) {
+	memset(&sched, 0, sizeof(sched));
+	sched.min_s = REPORT_SCHED_MIN_DEFAULT;
+	sched.max_s = REPORT_SCHED_MAX_DEFAULT;
+	sched.enabled = true;
+	last_send_failed = 0;
+}
+
+bool report_sched_set_bounds(uint16 min_s, uint16 max_s) {
+	if (min_s < REPORT_INTERVAL_MIN || max_s > REPORT_INTERVAL_MAX
+			|| min_s > max_s) {
+		return false;
+	}
+	sched.min_s = min_s;
+	sched.max_s = max_s;
+	printf("Report bounds %d..%d s\r\n", min_s, max_s);
+	return true;
+}
+
+void report_sched_set_enabled(bool enabled) {
+	sched.enabled = enabled;
+}
+
+void report_sched_get_state(report_sched_state_t *state) {
+	*state = sched;
+}
+
+void report_sched_note_change(void) {
+	sched.changes++;
+}
+
+void report_sched_note_alarm(void) {
+	sched.alarms++;
+}
+
+uint16 report_sched_update(uint16 current_s) {
+	uint32 next = current_s;
+
+	sched.congested = report_sched_congested();
+	if (!sched.enabled) {
+		sched.changes = 0;
+		sched.alarms = 0;
+		return current_s;
+	}
+
+	if (sched.alarms) {
+		next = sched.min_s;
+	} else if (sched.congested) {
+		next = current_s * 2;
+	} else if (sched.changes) {
+		next = current_s / 2;
+	} else {
+		next = current_s + current_s / 4 + 1;
+	}
+	if (next < sched.min_s) {
+		next = sched.min_s;
+	} else if (next > sched.max_s) {
+		next = sched.max_s;
+	}
+
+	sched.changes = 0;
+	sched.alarms = 0;
+	return (uint16) next;
+}
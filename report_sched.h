@@ -0,0 +1,43 @@
+/***************************************************************************//**
+ * @file
+ * @brief report_sched.h
+ * Adaptive period of the gateway report (TIMER_ID_CHECK_HEALTH).
+ ******************************************************************************/
+
+#ifndef REPORT_SCHED_H
+#define REPORT_SCHED_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Default bounds in seconds, the gateway can move them at runtime */
+#define REPORT_SCHED_MIN_DEFAULT		5
+#define REPORT_SCHED_MAX_DEFAULT		120
+
+/* Mesh node statistics growth per second regarded as a busy network */
+#define REPORT_SCHED_BUSY_PER_SEC		20
+
+typedef struct {
+	uint16 min_s;
+	uint16 max_s;
+	bool enabled;
+	bool congested;		/* result of the last evaluation */
+	uint16 changes;		/* since the last tick */
+	uint16 alarms;
+} report_sched_state_t;
+
+void report_sched_init(void);
+bool report_sched_set_bounds(uint16 min_s, uint16 max_s);
+void report_sched_set_enabled(bool enabled);
+void report_sched_get_state(report_sched_state_t *state);
+
+/* Event inputs from the LPN data path */
+void report_sched_note_change(void);
+void report_sched_note_alarm(void);
+
+/* Called once per report tick before its report is queued, so only records
+ * left over from earlier reports count as backlog. Returns the interval for
+ * the next period. */
+uint16 report_sched_update(uint16 current_s);
+
+#endif /* REPORT_SCHED_H */
@@ -0,0 +1,167 @@
+/***************************************************************************//**
+ * @file
+ * @brief send_queue.c
+ * One ring per priority class. A token is earned every pace_ms, which is the
+ * time the stack needs to put one network PDU on air with the current network
+ * transmit count and interval, so a burst of reports cannot overrun the stack
+ * TX queue. Messages the stack refuses stay at the head of their ring and are
+ * retried on the next token.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "receive_node.h"
+#include "send_queue.h"
+
+typedef struct {
+	uint16 message;
+	uint8 response_flag;
+	uint8 retries;
+} send_entry_t;
+
+typedef struct {
+	send_entry_t entry[SEND_QUEUE_DEPTH];
+	uint8 head;
+	uint8 count;
+} send_ring_t;
+
+static send_ring_t send_rings[SEND_PRIO_NUM];
+static send_queue_tx_fn send_tx;
+static send_queue_stats_t send_stats;
+
+static uint8 tokens;
+static uint32 last_refill_ms;
+static uint16 pace_ms = SEND_PACE_MIN_MS;
+static bool pacer_running;
+
+void send_queue_init(send_queue_tx_fn tx) {
+	memset(send_rings, 0, sizeof(send_rings));
+	memset(&send_stats, 0, sizeof(send_stats));
+	send_tx = tx;
+	tokens = SEND_BUCKET_SIZE;
+	last_refill_ms = app_time_ms();
+	pacer_running = false;
+	app_timer_register(TIMER_ID_SEND_QUEUE, send_queue_process);
+}
+
+void send_queue_update_pacing(void) {
+	struct gecko_msg_mesh_test_get_nettx_rsp_t *nettx =
+			gecko_cmd_mesh_test_get_nettx();
+	uint16 period;
+
+	if (nettx->result) {
+		printf("Get nettx failed, keep pacing %d ms\r\n", pace_ms);
+		return;
+	}
+	//Each of the (count + 1) transmissions takes up to 10 * (2 + steps) ms
+	period = (nettx->count + 1) * 10 * (2 + nettx->interval);
+	pace_ms = period > SEND_PACE_MIN_MS ? period : SEND_PACE_MIN_MS;
+	printf("Send pacing %d ms (nettx %d, %d)\r\n", pace_ms, nettx->count,
+			nettx->interval);
+}
+
+static void send_refill(void) {
+	uint32 now = app_time_ms();
+	uint32 earned = (uint32) (now - last_refill_ms) / pace_ms;
+
+	if (tokens + earned >= SEND_BUCKET_SIZE) {
+		tokens = SEND_BUCKET_SIZE;
+		last_refill_ms = now;
+	} else {
+		tokens += earned;
+		last_refill_ms += earned * pace_ms;
+	}
+}
+
+static send_ring_t *send_next_ring(void) {
+	uint8 prio;
+	for (prio = 0; prio < SEND_PRIO_NUM; prio++) {
+		if (send_rings[prio].count) {
+			return &send_rings[prio];
+		}
+	}
+	return NULL;
+}
+
+static void send_pop(send_ring_t *ring) {
+	ring->head = (ring->head + 1) & (SEND_QUEUE_DEPTH - 1);
+	ring->count--;
+}
+
+static void send_schedule(void) {
+	bool pending = send_next_ring() != NULL;
+
+	if (pending && !pacer_running) {
+		app_timer_set(
+				((uint32) pace_ms * APP_TIME_TICKS_PER_SEC) / 1000,
+				TIMER_ID_SEND_QUEUE, 0);
+		pacer_running = true;
+	} else if (!pending && pacer_running) {
+		app_timer_set(0, TIMER_ID_SEND_QUEUE, 0);
+		pacer_running = false;
+	}
+}
+
+bool send_queue_push(uint8 prio, uint8 response_flag, uint16 message) {
+	send_ring_t *ring;
+	send_entry_t *e;
+
+	if (prio >= SEND_PRIO_NUM) {
+		return false;
+	}
+	ring = &send_rings[prio];
+	if (ring->count == SEND_QUEUE_DEPTH) {
+		send_stats.dropped++;
+		printf("Send queue %d full, drop %x !!!\r\n", prio, message);
+		return false;
+	}
+	e = &ring->entry[(ring->head + ring->count) & (SEND_QUEUE_DEPTH - 1)];
+	e->message = message;
+	e->response_flag = response_flag;
+	e->retries = 0;
+	ring->count++;
+
+	send_queue_process();
+	return true;
+}
+
+void send_queue_process(void) {
+	send_ring_t *ring;
+
+	send_refill();
+	while (tokens > 0 && (ring = send_next_ring()) != NULL) {
+		send_entry_t *e = &ring->entry[ring->head];
+		//A refused attempt never went on air: a retry takes a new transaction
+		//id, the old one may be in use by a send that went out meanwhile
+		uint16 result = send_tx(e->response_flag, FLAG_NON_RETRANS, e->message);
+		tokens--;
+		if (result == 0) {
+			send_stats.sent++;
+			send_pop(ring);
+			continue;
+		}
+		send_stats.failed++;
+		if (++e->retries > SEND_MAX_RETRIES) {
+			send_stats.dropped++;
+			send_pop(ring);
+		}
+		//The stack is busy, back off until the next token
+		tokens = 0;
+	}
+	send_schedule();
+}
+
+void send_queue_get_stats(send_queue_stats_t *stats) {
+	uint8 prio;
+
+	*stats = send_stats;
+	stats->pace_ms = pace_ms;
+	for (prio = 0; prio < SEND_PRIO_NUM; prio++) {
+		stats->pending[prio] = send_rings[prio].count;
+	}
+}
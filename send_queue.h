@@ -0,0 +1,50 @@
+/***************************************************************************//**
+ * @file
+ * @brief send_queue.h
+ * Prioritized, token bucket paced queue in front of send_mesh_data().
+ ******************************************************************************/
+
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+/* Priority classes, lower value is sent first */
+#define SEND_PRIO_ALARM			0
+#define SEND_PRIO_STATE			1
+#define SEND_PRIO_PERIODIC		2
+#define SEND_PRIO_NUM			3
+
+/* Entries per priority class, must be a power of two */
+#define SEND_QUEUE_DEPTH		16
+/* Attempts after the first one when the stack refuses a message */
+#define SEND_MAX_RETRIES		3
+/* Messages that may leave back to back after an idle period */
+#define SEND_BUCKET_SIZE		4
+/* Lower bound of the pacing period in ms */
+#define SEND_PACE_MIN_MS		40
+
+#define TIMER_ID_SEND_QUEUE		82
+
+/* Transmit function, returns the BGAPI result of the send */
+typedef uint16 (*send_queue_tx_fn)(uint8 response_flag, uint8 retransmit,
+		uint16 message);
+
+typedef struct {
+	uint32 sent;
+	uint32 failed;
+	uint32 dropped;
+	uint16 pace_ms;
+	uint8 pending[SEND_PRIO_NUM];
+} send_queue_stats_t;
+
+void send_queue_init(send_queue_tx_fn tx);
+/* Derive the token period from the network transmit state */
+void send_queue_update_pacing(void);
+bool send_queue_push(uint8 prio, uint8 response_flag, uint16 message);
+/* Send as much as the bucket allows, called on TIMER_ID_SEND_QUEUE */
+void send_queue_process(void);
+void send_queue_get_stats(send_queue_stats_t *stats);
+
+#endif /* SEND_QUEUE_H */
@@ -0,0 +1,631 @@
+/***************************************************************************//**
+ * @file
+ * @brief serial_shell.c
+ * Characters are buffered by the retarget serial RX interrupt, which wakes the
+ * BGAPI loop with an external signal. serial_shell_process() then consumes
+ * whatever is in the ring and runs each complete line.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "native_gecko.h"
+#include "retargetserial.h"
+#include "i2casync.h"
+
+#include "mesh_data.h"
+#include "lpn_table.h"
+#include "dedup_cache.h"
+#include "send_queue.h"
+#include "report_sched.h"
+#include "node_stats.h"
+#include "env_sensor.h"
+#include "report_auth.h"
+#include "node_store.h"
+#include "vendor_data.h"
+#include "conn_policy.h"
+#include "event_trace.h"
+#include "prof.h"
+#include "stack_mon.h"
+#include "alarm_coalesce.h"
+#include "gw_health.h"
+#include "node_hb.h"
+#include "time_sync.h"
+#include "app_time.h"
+#include "app_timer.h"
+#include "event_dispatch.h"
+#include "work_queue.h"
+#include "receive_node.h"
+#include "serial_shell.h"
+
+#define SHELL_PROMPT	"> "
+
+typedef struct {
+	const char *name;
+	void (*handler)(int argc, char **argv);
+	const char *help;
+} shell_cmd_t;
+
+static void cmd_help(int argc, char **argv);
+static void cmd_lpn(int argc, char **argv);
+static void cmd_counters(int argc, char **argv);
+static void cmd_heap(int argc, char **argv);
+static void cmd_dedup(int argc, char **argv);
+static void cmd_txq(int argc, char **argv);
+static void cmd_interval(int argc, char **argv);
+static void cmd_sched(int argc, char **argv);
+static void cmd_stats(int argc, char **argv);
+static void cmd_sensor(int argc, char **argv);
+static void cmd_auth(int argc, char **argv);
+static void cmd_store(int argc, char **argv);
+static void cmd_vendor(int argc, char **argv);
+static void cmd_conn(int argc, char **argv);
+static void cmd_trace(int argc, char **argv);
+static void cmd_prof(int argc, char **argv);
+static void cmd_stack(int argc, char **argv);
+static void cmd_alarm(int argc, char **argv);
+static void cmd_gw(int argc, char **argv);
+static void cmd_hb(int argc, char **argv);
+static void cmd_time(int argc, char **argv);
+static void cmd_timers(int argc, char **argv);
+static void cmd_events(int argc, char **argv);
+static void cmd_work(int argc, char **argv);
+static void cmd_reset(int argc, char **argv);
+
+static const shell_cmd_t shell_cmds[] = {
+	{ "help", cmd_help, "list commands" },
+	{ "lpn", cmd_lpn, "dump LPN table" },
+	{ "counters", cmd_counters, "radio counter totals" },
+	{ "stats", cmd_stats, "sampled rates [n|pub on|pub off]" },
+	{ "sensor", cmd_sensor, "environment sensor [cadence s|delta t rh]" },
+	{ "auth", cmd_auth, "report auth [on|off|clear|key <hex>|bench [len]]" },
+	{ "store", cmd_store, "LPN table snapshot writes [flush]" },
+	{ "vendor", cmd_vendor, "vendor model channel" },
+	{ "conn", cmd_conn, "GATT connections [<handle> proxy|readout|idle]" },
+	{ "trace", cmd_trace, "event trace [on|off|clear|dump]" },
+	{ "prof", cmd_prof, "cycle profile per probe [clear]" },
+	{ "heap", cmd_heap, "heap usage" },
+	{ "stack", cmd_stack, "stack high watermark" },
+	{ "dedup", cmd_dedup, "duplicate cache hits/misses [clear]" },
+	{ "txq", cmd_txq, "outbound send queue" },
+	{ "interval", cmd_interval, "get/set fixed report interval [s]" },
+	{ "sched", cmd_sched, "adaptive interval [on|off|<min> <max>]" },
+	{ "alarm", cmd_alarm, "alarm coalescing [window <ms>]" },
+	{ "gw", cmd_gw, "gateway heartbeat liveness" },
+	{ "hb", cmd_hb, "own heartbeat publication [<period log> <ttl>]" },
+	{ "time", cmd_time, "gateway time sync [sync|interval <s>]" },
+	{ "timers", cmd_timers, "multiplexed soft timers" },
+	{ "events", cmd_events, "event and timer handlers [clear]" },
+	{ "work", cmd_work, "deferred work queue" },
+	{ "reset", cmd_reset, "reboot the node" },
+};
+
+#define SHELL_NUM_CMDS	(sizeof(shell_cmds) / sizeof(shell_cmds[0]))
+
+static char line_buf[SHELL_LINE_LEN];
+static uint8 line_len;
+static bool line_overflow;
+
+/* Runs in interrupt context, only wake up the main loop */
+void RETARGET_SerialRxHook(int c) {
+	(void) c;
+	gecko_external_signal(SHELL_EXT_SIGNAL);
+}
+
+void serial_shell_init(void) {
+	line_len = 0;
+	line_overflow = false;
+}
+
+static void shell_execute(char *line) {
+	char *argv[SHELL_MAX_ARGS];
+	int argc = 0;
+	char *tok = strtok(line, " \t");
+
+	while (tok != NULL && argc < SHELL_MAX_ARGS) {
+		argv[argc++] = tok;
+		tok = strtok(NULL, " \t");
+	}
+	if (argc == 0) {
+		return;
+	}
+
+	uint8 i;
+	for (i = 0; i < SHELL_NUM_CMDS; i++) {
+		if (strcmp(argv[0], shell_cmds[i].name) == 0) {
+			shell_cmds[i].handler(argc, argv);
+			return;
+		}
+	}
+	printf("Unknown command '%s', try 'help'\r\n", argv[0]);
+}
+
+void serial_shell_process(void) {
+	int c;
+
+	while ((c = RETARGET_ReadChar()) >= 0) {
+		if (c == '\r' || c == '\n') {
+			if (line_len == 0 && !line_overflow) {
+				continue;
+			}
+			printf("\r\n");
+			if (line_overflow) {
+				printf("Line too long !!!\r\n");
+			} else {
+				line_buf[line_len] = '\0';
+				shell_execute(line_buf);
+			}
+			line_len = 0;
+			line_overflow = false;
+			printf(SHELL_PROMPT);
+		} else if (c == '\b' || c == 0x7f) {
+			if (line_len > 0) {
+				line_len--;
+				printf("\b \b");
+			}
+		} else if (line_len < SHELL_LINE_LEN - 1) {
+			line_buf[line_len++] = (char) c;
+			RETARGET_WriteChar((char) c);
+		} else {
+			line_overflow = true;
+		}
+	}
+}
+
+static void cmd_help(int argc, char **argv) {
+	uint8 i;
+	for (i = 0; i < SHELL_NUM_CMDS; i++) {
+		printf("%-10s %s\r\n", shell_cmds[i].name, shell_cmds[i].help);
+	}
+}
+
+static void cmd_lpn(int argc, char **argv) {
+	uint8 i;
+
+	printf("num_lpn %d alarm %08lx dead %08lx dirty %08lx\r\n",
+			lpn_table.count, (unsigned long) lpn_table.alarm,
+			(unsigned long) lpn_table_dead(), (unsigned long) lpn_table.dirty);
+	printf("addr alarm hb batt timeout\r\n");
+	for (i = 0; i < lpn_table.count; i++) {
+		printf("%4x %5d %2d %4d %7d\r\n", lpn_table.address[i],
+				(int) ((lpn_table.alarm >> i) & 1),
+				(int) ((lpn_table.alive >> i) & 1), lpn_table.battery[i],
+				lpn_table.time_out[i]);
+	}
+}
+
+static void cmd_counters(int argc, char **argv) {
+	node_stats_totals_t t;
+
+	node_stats_get_totals(&t);
+	printf("tx %lu rx %lu crc %lu fail %lu coex denied %lu",
+			(unsigned long) t.tx_packets, (unsigned long) t.rx_packets,
+			(unsigned long) t.crc_errors, (unsigned long) t.tx_failures,
+			(unsigned long) t.coex_denied);
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	printf(" relay drop %lu", (unsigned long) t.relay_drops);
+#endif
+	printf("\r\n");
+}
+
+static void cmd_stats(int argc, char **argv) {
+	node_stats_sample_t s;
+	unsigned long n = NODE_STATS_RING_LEN;
+	uint8 i;
+
+	if (argc > 2 && strcmp(argv[1], "pub") == 0) {
+		node_stats_set_publish(strcmp(argv[2], "on") == 0);
+		return;
+	}
+	if (argc > 1) {
+		n = strtoul(argv[1], NULL, 0);
+	}
+#ifdef NODE_STATS_RELAY_DROP_WORD
+	printf("age tx/s rx/s crc fail coex mesh relay\r\n");
+#else
+	printf("age tx/s rx/s crc fail coex mesh\r\n");
+#endif
+	for (i = 0; i < n && node_stats_get(i, &s); i++) {
+		printf("%3d %3d.%d %3d.%d %3d %4d %4d %4d", i,
+				s.tx_pps_x10 / 10, s.tx_pps_x10 % 10, s.rx_pps_x10 / 10,
+				s.rx_pps_x10 % 10, s.crc_errors, s.tx_failures, s.coex_denied,
+				s.mesh_events);
+#ifdef NODE_STATS_RELAY_DROP_WORD
+		printf(" %5d", s.relay_drops);
+#endif
+		printf("\r\n");
+	}
+}
+
+static void cmd_heap(int argc, char **argv) {
+	struct mallinfo mi = mallinfo();
+
+	printf("heap arena %u used %u free %u\r\n", (unsigned) mi.arena,
+			(unsigned) mi.uordblks, (unsigned) mi.fordblks);
+}
+
+static void cmd_dedup(int argc, char **argv) {
+	dedup_cache_stats_t stats;
+
+	dedup_cache_get_stats(&stats);
+	printf("dedup hits %lu misses %lu\r\n", (unsigned long) stats.hits,
+			(unsigned long) stats.misses);
+	if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+		dedup_cache_clear_stats();
+	}
+}
+
+static void cmd_txq(int argc, char **argv) {
+	send_queue_stats_t stats;
+
+	send_queue_get_stats(&stats);
+	printf("pace %d ms pending alarm %d state %d periodic %d\r\n",
+			stats.pace_ms, stats.pending[SEND_PRIO_ALARM],
+			stats.pending[SEND_PRIO_STATE], stats.pending[SEND_PRIO_PERIODIC]);
+	printf("sent %lu failed %lu dropped %lu\r\n", (unsigned long) stats.sent,
+			(unsigned long) stats.failed, (unsigned long) stats.dropped);
+}
+
+static void cmd_interval(int argc, char **argv) {
+	if (argc > 1) {
+		unsigned long seconds = strtoul(argv[1], NULL, 0);
+		if (seconds > REPORT_INTERVAL_MAX
+				|| !receive_node_set_report_interval((uint16) seconds)) {
+			printf("Interval must be %d..%d s\r\n", REPORT_INTERVAL_MIN,
+					REPORT_INTERVAL_MAX);
+			return;
+		}
+		//A fixed interval overrides the adaptive scheduler
+		report_sched_set_enabled(false);
+	}
+	printf("report interval %d s\r\n", receive_node_get_report_interval());
+}
+
+static void cmd_reset(int argc, char **argv) {
+	node_store_flush();
+	gecko_cmd_system_reset(0);
+}
+
+static void cmd_sched(int argc, char **argv) {
+	report_sched_state_t sched;
+
+	if (argc == 2) {
+		report_sched_set_enabled(strcmp(argv[1], "on") == 0);
+	} else if (argc > 2) {
+		unsigned long min_s = strtoul(argv[1], NULL, 0);
+		unsigned long max_s = strtoul(argv[2], NULL, 0);
+		if (min_s > REPORT_INTERVAL_MAX || max_s > REPORT_INTERVAL_MAX
+				|| !report_sched_set_bounds((uint16) min_s, (uint16) max_s)) {
+			printf("Bounds must be %d <= min <= max <= %d s\r\n",
+					REPORT_INTERVAL_MIN, REPORT_INTERVAL_MAX);
+			return;
+		}
+	}
+	report_sched_get_state(&sched);
+	printf("adaptive %s bounds %d..%d s interval %d s congested %d\r\n",
+			sched.enabled ? "on" : "off", sched.min_s, sched.max_s,
+			receive_node_get_report_interval(), sched.congested);
+}
+
+static void cmd_sensor(int argc, char **argv) {
+	env_sensor_state_t st;
+	I2CASYNC_Stats_TypeDef i2c;
+
+	if (argc > 2 && strcmp(argv[1], "cadence") == 0) {
+		env_sensor_set_cadence((uint16) strtoul(argv[2], NULL, 0));
+	} else if (argc > 3 && strcmp(argv[1], "delta") == 0) {
+		env_sensor_set_thresholds((uint8) strtoul(argv[2], NULL, 0),
+				(uint16) strtoul(argv[3], NULL, 0));
+	}
+	env_sensor_get_state(&st);
+	if (!st.present) {
+		printf("no sensor\r\n");
+		return;
+	}
+	int t_tenths = abs(st.temperature * 5);
+	printf("t %s%d.%d C rh %u.%02u %% cadence %d s delta %d/%d\r\n",
+			st.temperature < 0 ? "-" : "", t_tenths / 10, t_tenths % 10,
+			st.humidity / 100, st.humidity % 100, st.cadence_s, st.temp_delta,
+			st.rh_delta);
+	printf("measurements %lu errors %lu publications %lu\r\n",
+			(unsigned long) st.measurements, (unsigned long) st.errors,
+			(unsigned long) st.publications);
+	I2CASYNC_GetStats(&i2c);
+	printf("i2c done %lu failed %lu rejected %lu\r\n",
+			(unsigned long) i2c.done, (unsigned long) i2c.failed,
+			(unsigned long) i2c.rejected);
+}
+
+static bool parse_hex(const char *str, uint8 *out, uint8 len) {
+	uint8 i;
+	char byte[3] = { 0 };
+
+	if (strlen(str) != 2 * len) {
+		return false;
+	}
+	for (i = 0; i < len; i++) {
+		char *end;
+		byte[0] = str[2 * i];
+		byte[1] = str[2 * i + 1];
+		out[i] = (uint8) strtoul(byte, &end, 16);
+		if (*end != '\0') {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void cmd_auth(int argc, char **argv) {
+	report_auth_state_t st;
+	uint8 key[REPORT_AUTH_KEY_LEN];
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		unsigned long len = argc > 2 ? strtoul(argv[2], NULL, 0) : 16;
+		uint32 cycles;
+
+		if (len == 0 || len > REPORT_AUTH_MAX_LEN) {
+			printf("len 1..%d\r\n", REPORT_AUTH_MAX_LEN);
+			return;
+		}
+		cycles = report_auth_bench((uint16) len);
+		printf("ccm %lu bytes %lu cycles %lu bytes/kcycle\r\n", len,
+				(unsigned long) cycles,
+				cycles ? (unsigned long) (len * 1000 / cycles) : 0);
+		return;
+	}
+	if (argc > 2 && strcmp(argv[1], "key") == 0) {
+		if (!parse_hex(argv[2], key, sizeof(key))) {
+			printf("key is %d hex bytes\r\n", REPORT_AUTH_KEY_LEN);
+			return;
+		}
+		report_auth_set_key(key);
+	} else if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+		report_auth_clear_key();
+	} else if (argc > 1 && strcmp(argv[1], "on") == 0) {
+		report_auth_enable(true);
+	} else if (argc > 1 && strcmp(argv[1], "off") == 0) {
+		report_auth_enable(false);
+	}
+	report_auth_get_state(&st);
+	printf("key %s auth %s counter %lu reports %lu overflows %lu\r\n",
+			st.key_present ? "set" : "none", st.enabled ? "on" : "off",
+			(unsigned long) st.frame_counter, (unsigned long) st.reports,
+			(unsigned long) st.overflows);
+}
+
+static void cmd_store(int argc, char **argv) {
+	node_store_stats_t st;
+
+	if (argc > 1 && strcmp(argv[1], "flush") == 0) {
+		node_store_flush();
+	}
+	node_store_get_stats(&st);
+	printf("writes %lu unchanged %lu failures %lu %s\r\n",
+			(unsigned long) st.writes, (unsigned long) st.unchanged,
+			(unsigned long) st.failures, st.dirty ? "dirty" : "clean");
+}
+
+static void cmd_vendor(int argc, char **argv) {
+	vendor_data_stats_t st;
+
+	vendor_data_get_stats(&st);
+	printf("gateway %s telemetry %lu failures %lu rx %lu malformed %lu\r\n",
+			st.gateway_seen ? "vendor" : "level",
+			(unsigned long) st.telemetry_sent, (unsigned long) st.send_failures,
+			(unsigned long) st.received, (unsigned long) st.malformed);
+}
+
+static void cmd_conn(int argc, char **argv) {
+	conn_policy_info_t c;
+	uint8 i;
+
+	if (argc > 2) {
+		uint8 role;
+
+		for (role = 0; role < CONN_PROFILE_COUNT; role++) {
+			if (strcmp(argv[2], conn_policy_profile_name(role)) == 0) {
+				break;
+			}
+		}
+		if (!conn_policy_set_role(atoi(argv[1]), role)) {
+			printf("no such connection or profile\r\n");
+			return;
+		}
+	}
+	for (i = 0; conn_policy_get_info(i, &c); i++) {
+		printf("conn %d %s/%s interval %d latency %d timeout %d phy %d\r\n",
+				c.connection, conn_policy_profile_name(c.role),
+				conn_policy_profile_name(c.profile), c.interval, c.latency,
+				c.timeout, c.phy);
+		printf("  txsize %d mtu %d update %d ms bytes %lu rate %d/%d B/s"
+				" idle %lu s updates %lu rejects %lu\r\n", c.txsize, c.mtu,
+				c.update_ms, (unsigned long) c.bytes, c.rate, c.peak_rate,
+				(unsigned long) c.idle_s, (unsigned long) c.updates,
+				(unsigned long) c.rejects);
+	}
+	if (i == 0) {
+		printf("no connections\r\n");
+	}
+}
+
+static void cmd_trace(int argc, char **argv) {
+	if (argc > 1) {
+		if (strcmp(argv[1], "on") == 0) {
+			event_trace_enable(true);
+		} else if (strcmp(argv[1], "off") == 0) {
+			event_trace_enable(false);
+		} else if (strcmp(argv[1], "clear") == 0) {
+			event_trace_clear();
+		} else if (strcmp(argv[1], "dump") == 0) {
+			event_trace_dump();
+			return;
+		}
+	}
+	printf("trace %s, %d of %d entries\r\n",
+			event_trace_enabled() ? "on" : "off", event_trace_count(),
+			EVENT_TRACE_DEPTH);
+}
+
+static void cmd_prof(int argc, char **argv) {
+#if APP_PROFILE
+	prof_stats_t p;
+	uint8 i;
+	uint8 b;
+
+	if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+		prof_clear();
+		return;
+	}
+	printf("probe                count      min      avg      max\r\n");
+	for (i = 0; prof_get(i, &p); i++) {
+		if (p.count == 0) {
+			continue;
+		}
+		printf("%-19s %6lu %8lu %8lu %8lu\r\n", prof_name(i),
+				(unsigned long) p.count, (unsigned long) p.min,
+				(unsigned long) (p.total / p.count), (unsigned long) p.max);
+		printf("  log2");
+		for (b = 0; b < PROF_BUCKETS; b++) {
+			if (p.hist[b]) {
+				printf(" %d:%u", b, p.hist[b]);
+			}
+		}
+		printf("\r\n");
+	}
+#else
+	printf("profiling not built, define APP_PROFILE=1\r\n");
+#endif
+}
+
+static void cmd_stack(int argc, char **argv) {
+	stack_mon_state_t st;
+
+	stack_mon_check();
+	stack_mon_get_state(&st);
+	printf("stack used %lu of %lu bytes (%lu%%)%s\r\n",
+			(unsigned long) st.used, (unsigned long) st.size,
+			(unsigned long) (st.size ? st.used * 100 / st.size : 0),
+			st.warned ? " over threshold" : "");
+}
+
+static void cmd_alarm(int argc, char **argv) {
+	alarm_coalesce_stats_t st;
+
+	if (argc > 2 && strcmp(argv[1], "window") == 0) {
+		alarm_coalesce_set_window(strtoul(argv[2], NULL, 0));
+	}
+	alarm_coalesce_get_stats(&st);
+	printf("window %lu ms immediate %lu merged %lu summaries %lu full %lu\r\n",
+			(unsigned long) st.window_ms, (unsigned long) st.immediate,
+			(unsigned long) st.merged, (unsigned long) st.summaries,
+			(unsigned long) st.table_full);
+}
+
+static void cmd_gw(int argc, char **argv) {
+	gw_health_info_t gw;
+	uint8 i;
+
+	printf("active %x\r\n", gw_health_active());
+	printf("addr alive miss hops  loss windows  hb rx/exp last seen\r\n");
+	for (i = 0; gw_health_get(i, &gw); i++) {
+		printf("%4x %5s %4d %2d-%-2d %4d%% %7lu %5lu/%-5lu %lu ms\r\n",
+				gw.address, gw.alive ? "yes" : "no", gw.misses, gw.hop_min,
+				gw.hop_max, gw.loss_pct, (unsigned long) gw.windows,
+				(unsigned long) gw.received, (unsigned long) gw.expected,
+				(unsigned long) gw.last_seen_ms);
+	}
+}
+
+static void cmd_hb(int argc, char **argv) {
+	node_hb_state_t hb;
+
+	if (argc > 2
+			&& !node_hb_configure(strtoul(argv[1], NULL, 0),
+					strtoul(argv[2], NULL, 0))) {
+		printf("period log 1..%d, ttl 0..%d\r\n", NODE_HB_PERIOD_LOG_MAX,
+				NODE_HB_TTL_MAX);
+	}
+	node_hb_get_state(&hb);
+	printf("heartbeat %s to %x period log %d ttl %d result 0x%x\r\n",
+			hb.running ? "on" : "off", hb.destination, hb.period_log, hb.ttl,
+			hb.last_result);
+}
+
+static void cmd_time(int argc, char **argv) {
+	time_sync_state_t sync;
+	uint32 now = app_time_ms();
+
+	if (argc > 1 && strcmp(argv[1], "sync") == 0) {
+		time_sync_request_now();
+	} else if (argc > 2 && strcmp(argv[1], "interval") == 0
+			&& !time_sync_set_interval(strtoul(argv[2], NULL, 0))) {
+		printf("interval at least %d s\r\n", TIME_SYNC_INTERVAL_S_MIN);
+	}
+	time_sync_get_state(&sync);
+	printf("local %lu ms gateway %lu ms %s\r\n", (unsigned long) now,
+			(unsigned long) time_sync_to_gateway(now),
+			sync.synced ? "synced" : "not synced");
+	printf("offset %lu drift %ld ppm rtt %u ms interval %u s\r\n",
+			(unsigned long) sync.offset_ms, (long) sync.drift_ppm, sync.rtt_ms,
+			sync.interval_s);
+	printf("samples %lu rejected %lu unanswered %u\r\n",
+			(unsigned long) sync.samples, (unsigned long) sync.rejected,
+			sync.attempts);
+}
+
+static void cmd_timers(int argc, char **argv) {
+	app_timer_stats_t timers;
+
+	app_timer_get_stats(&timers);
+	printf("timers %d of %d, %d lazy\r\n", timers.active, APP_TIMER_MAX,
+			timers.lazy);
+	printf("expiries %lu wakeups %lu worst late %lu ticks\r\n",
+			(unsigned long) timers.expiries, (unsigned long) timers.wakeups,
+			(unsigned long) timers.late_ticks);
+}
+
+static void print_cost(const dispatch_cost_t *cost) {
+#if APP_PROFILE
+	printf(" %6lu %8lu %8lu\r\n", (unsigned long) cost->count,
+			(unsigned long) (cost->count ? cost->total_cycles / cost->count : 0),
+			(unsigned long) cost->max_cycles);
+#else
+	printf(" %6lu\r\n", (unsigned long) cost->count);
+#endif
+}
+
+static void cmd_events(int argc, char **argv) {
+	event_dispatch_info_t evt;
+	app_timer_handler_info_t timer;
+	uint8 i;
+
+	if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+		event_dispatch_clear_costs();
+		app_timer_clear_costs();
+		return;
+	}
+	printf("event      handler     calls      avg      max\r\n");
+	for (i = 0; event_dispatch_get(i, &evt); i++) {
+		printf("%08lx %p", (unsigned long) evt.evt_id, (void *) evt.handler);
+		print_cost(&evt.cost);
+	}
+	printf("timer      handler\r\n");
+	for (i = 0; app_timer_get_handler(i, &timer); i++) {
+		printf("%8d %p", timer.id, (void *) timer.handler);
+		print_cost(&timer.cost);
+	}
+}
+
+static void cmd_work(int argc, char **argv) {
+	work_queue_stats_t work;
+
+	work_queue_get_stats(&work);
+	printf("posted %lu coalesced %lu dropped %lu run %lu\r\n",
+			(unsigned long) work.posted, (unsigned long) work.coalesced,
+			(unsigned long) work.dropped, (unsigned long) work.run);
+	printf("drains %lu over budget %lu max depth %d longest %lu ticks\r\n",
+			(unsigned long) work.drains, (unsigned long) work.over_budget,
+			work.max_depth, (unsigned long) work.max_item_ticks);
+}
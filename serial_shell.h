@@ -0,0 +1,22 @@
+/***************************************************************************//**
+ * @file
+ * @brief serial_shell.h
+ * Line oriented command shell on the VCOM serial port.
+ ******************************************************************************/
+
+#ifndef SERIAL_SHELL_H
+#define SERIAL_SHELL_H
+
+#include "bg_types.h"
+
+/* External signal raised by the serial RX interrupt */
+#define SHELL_EXT_SIGNAL	0x00000001
+
+#define SHELL_LINE_LEN		64
+#define SHELL_MAX_ARGS		4
+
+void serial_shell_init(void);
+/* Drain the RX ring and execute complete lines, never blocks on input */
+void serial_shell_process(void);
+
+#endif /* SERIAL_SHELL_H */
@@ -0,0 +1,68 @@
+/***************************************************************************//**
+ * @file
+ * @brief stack_mon.c
+ * The application runs without an RTOS, so thread code and every interrupt
+ * handler share the main stack: the watermark covers the deepest thread path
+ * plus whatever interrupts nested on top of it. The stack sits at the bottom
+ * of RAM and grows down towards __StackLimit, the scan starts there and stops
+ * at the first overwritten word.
+ ******************************************************************************/
+
+#include <stdio.h>
+
+#include "em_device.h"
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "stack_mon.h"
+
+/* Left unpainted below the caller's frame */
+#define STACK_MON_GUARD		32
+
+extern uint32 __StackLimit;
+extern uint32 __StackTop;
+
+static stack_mon_state_t mon;
+static stack_mon_warn_fn mon_warn;
+
+void stack_mon_paint(void) {
+	uint32 *p = &__StackLimit;
+	uint32 *end = (uint32 *) (__get_MSP() - STACK_MON_GUARD);
+
+	while (p < end) {
+		*p++ = STACK_MON_PATTERN;
+	}
+	mon.size = (uint32) &__StackTop - (uint32) &__StackLimit;
+}
+
+void stack_mon_start(stack_mon_warn_fn warn) {
+	mon_warn = warn;
+	app_timer_register(TIMER_ID_STACK_MON, stack_mon_check);
+	stack_mon_check();
+	app_timer_set_lazy(STACK_MON_PERIOD_S * APP_TIME_TICKS_PER_SEC,
+			APP_TIMER_SLACK(STACK_MON_PERIOD_S * APP_TIME_TICKS_PER_SEC),
+			TIMER_ID_STACK_MON, 0);
+}
+
+void stack_mon_check(void) {
+	const uint32 *p = &__StackLimit;
+	const uint32 *top = &__StackTop;
+
+	while (p < top && *p == STACK_MON_PATTERN) {
+		p++;
+	}
+	mon.used = (uint32) top - (uint32) p;
+	mon.checks++;
+
+	if (!mon.warned && mon.used * 100 >= mon.size * STACK_MON_WARN_PCT) {
+		mon.warned = true;
+		if (mon_warn != NULL) {
+			mon_warn(mon.used, mon.size);
+		}
+	}
+}
+
+void stack_mon_get_state(stack_mon_state_t *state) {
+	*state = mon;
+}
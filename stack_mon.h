@@ -0,0 +1,38 @@
+/***************************************************************************//**
+ * @file
+ * @brief stack_mon.h
+ * High watermark of the stack, from a pattern painted at startup.
+ ******************************************************************************/
+
+#ifndef STACK_MON_H
+#define STACK_MON_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#define STACK_MON_PATTERN		0xcdcdcdcd
+#define STACK_MON_PERIOD_S		10
+/* Warn once the watermark passes this share of the stack */
+#define STACK_MON_WARN_PCT		85
+
+#define TIMER_ID_STACK_MON		89
+
+typedef struct {
+	uint32 size;		/* bytes between __StackLimit and __StackTop */
+	uint32 used;		/* deepest use seen, bytes */
+	uint32 checks;
+	bool warned;
+} stack_mon_state_t;
+
+/* Called once the watermark first crosses STACK_MON_WARN_PCT */
+typedef void (*stack_mon_warn_fn)(uint32 used, uint32 size);
+
+/* Paint the unused stack, first thing in main() */
+void stack_mon_paint(void);
+/* Start periodic checks once the stack is booted */
+void stack_mon_start(stack_mon_warn_fn warn);
+/* TIMER_ID_STACK_MON handler, also usable on demand */
+void stack_mon_check(void);
+void stack_mon_get_state(stack_mon_state_t *state);
+
+#endif /* STACK_MON_H */
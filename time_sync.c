@@ -0,0 +1,135 @@
+/***************************************************************************//**
+ * @file
+ * @brief time_sync.c
+ * One timestamp per answer, taken as the gateway time at the middle of the
+ * round trip. The offset is the last accepted sample; the drift is the slope
+ * between consecutive samples, smoothed, and extrapolates the offset between
+ * them. Times are uint32 ms on both sides, all differences wrap.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "native_gecko.h"
+
+#include "app_time.h"
+#include "app_timer.h"
+#include "time_sync.h"
+
+/* Until the first sample, to give the gateway time to see the node */
+#define TIME_SYNC_FIRST_S		10
+
+static time_sync_state_t state;
+static time_sync_request_fn send_request;
+static uint32 request_ms;
+static bool awaiting;
+static bool have_drift;
+
+void time_sync_init(time_sync_request_fn request) {
+	memset(&state, 0, sizeof(state));
+	state.interval_s = TIME_SYNC_INTERVAL_S_DEFAULT;
+	send_request = request;
+	awaiting = false;
+	have_drift = false;
+	app_timer_register(TIMER_ID_TIME_SYNC, time_sync_on_timer);
+}
+
+static void time_sync_schedule(uint16 seconds) {
+	app_timer_set_lazy(seconds * APP_TIME_TICKS_PER_SEC,
+			APP_TIMER_SLACK(seconds * APP_TIME_TICKS_PER_SEC), TIMER_ID_TIME_SYNC,
+			1);
+}
+
+void time_sync_start(void) {
+	time_sync_schedule(TIME_SYNC_FIRST_S);
+}
+
+bool time_sync_set_interval(uint16 seconds) {
+	if (seconds < TIME_SYNC_INTERVAL_S_MIN) {
+		return false;
+	}
+	state.interval_s = seconds;
+	if (state.synced) {
+		time_sync_schedule(seconds);
+	}
+	return true;
+}
+
+void time_sync_request_now(void) {
+	time_sync_on_timer();
+}
+
+void time_sync_on_gateway_change(void) {
+	state.synced = false;
+	state.attempts = 0;
+	state.drift_ppm = 0;
+	have_drift = false;
+	awaiting = false;
+	time_sync_request_now();
+}
+
+void time_sync_on_timer(void) {
+	state.seq++;
+	request_ms = app_time_ms();
+	awaiting = send_request != NULL && send_request(state.seq, request_ms);
+	if (state.attempts < 0xff) {
+		state.attempts++;
+	}
+	time_sync_schedule(
+			!state.synced && state.attempts < TIME_SYNC_RETRIES ?
+					TIME_SYNC_RETRY_S : state.interval_s);
+}
+
+void time_sync_on_status(uint8 seq, uint32 echo_ms, uint32 gateway_ms) {
+	uint32 now = app_time_ms();
+	uint32 rtt = now - echo_ms;
+	uint32 mid;
+	uint32 offset;
+
+	//Answers to an older request or delayed in the friend queue
+	if (!awaiting || seq != state.seq || echo_ms != request_ms
+			|| rtt > TIME_SYNC_RTT_MAX_MS) {
+		state.rejected++;
+		return;
+	}
+	mid = echo_ms + rtt / 2;
+	offset = gateway_ms - mid;
+	if (state.synced && mid - state.ref_ms >= TIME_SYNC_DRIFT_MIN_MS) {
+		int32 elapsed = mid - state.ref_ms;
+		int32 change = offset - state.offset_ms;
+		int32 ppm = (int32) ((int64_t) change * 1000000 / elapsed);
+
+		state.drift_ppm = have_drift ? (3 * state.drift_ppm + ppm) / 4 : ppm;
+		have_drift = true;
+	}
+	if (!state.synced) {
+		printf("Time synced, offset %lu ms rtt %lu ms\r\n",
+				(unsigned long) offset, (unsigned long) rtt);
+	}
+	state.synced = true;
+	state.attempts = 0;
+	state.offset_ms = offset;
+	state.ref_ms = mid;
+	state.rtt_ms = rtt;
+	state.samples++;
+	awaiting = false;
+}
+
+bool time_sync_is_synced(void) {
+	return state.synced;
+}
+
+uint32 time_sync_to_gateway(uint32 local_ms) {
+	int32 since;
+
+	if (!state.synced) {
+		return local_ms;
+	}
+	since = local_ms - state.ref_ms;
+	return local_ms + state.offset_ms
+			+ (int32) ((int64_t) state.drift_ppm * since / 1000000);
+}
+
+void time_sync_get_state(time_sync_state_t *out) {
+	*out = state;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************//**
+ * @file
+ * @brief time_sync.h
+ * Offset and drift of app_time against the gateway clock, estimated from
+ * request and status round trips over the vendor model.
+ ******************************************************************************/
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#define TIME_SYNC_INTERVAL_S_DEFAULT	600
+#define TIME_SYNC_INTERVAL_S_MIN		30
+/* Unanswered requests are retried this often, this many times, before
+ * falling back to the interval */
+#define TIME_SYNC_RETRY_S				30
+#define TIME_SYNC_RETRIES				4
+/* Round trips longer than this carry too much queueing to be trusted */
+#define TIME_SYNC_RTT_MAX_MS			1000
+/* Samples closer than this give no useful drift */
+#define TIME_SYNC_DRIFT_MIN_MS			60000
+
+#define TIMER_ID_TIME_SYNC				91
+
+typedef struct {
+	bool synced;
+	uint8 seq;			/* of the request in flight */
+	uint8 attempts;		/* unanswered requests since the last sample */
+	uint16 interval_s;
+	uint16 rtt_ms;		/* of the last accepted sample */
+	int32 drift_ppm;	/* gateway clock gain per 10^6 local */
+	uint32 offset_ms;	/* gateway - local at ref_ms, modulo 2^32 */
+	uint32 ref_ms;		/* local time of the last sample */
+	uint32 samples;
+	uint32 rejected;	/* stale, mismatched or slow answers */
+} time_sync_state_t;
+
+/* Sends a request: sequence and local send time, echoed by the gateway.
+ * False if it could not be sent. */
+typedef bool (*time_sync_request_fn)(uint8 seq, uint32 local_ms);
+
+void time_sync_init(time_sync_request_fn request);
+/* First request shortly after the node is provisioned */
+void time_sync_start(void);
+/* Request now, whatever the schedule */
+void time_sync_request_now(void);
+/* Another gateway took over: its clock is unrelated to the old one, forget
+ * offset and drift and request at once */
+void time_sync_on_gateway_change(void);
+bool time_sync_set_interval(uint16 seconds);
+/* TIMER_ID_TIME_SYNC handler */
+void time_sync_on_timer(void);
+/* Gateway answer: echoed sequence and send time, gateway time in ms */
+void time_sync_on_status(uint8 seq, uint32 echo_ms, uint32 gateway_ms);
+bool time_sync_is_synced(void);
+/* app_time_ms() value in gateway ms, unchanged while not synced */
+uint32 time_sync_to_gateway(uint32 local_ms);
+void time_sync_get_state(time_sync_state_t *state);
+
+#endif /* TIME_SYNC_H */
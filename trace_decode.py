@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Decode an event_trace dump captured from the serial shell ("trace dump").
+
+Reads a serial log, keeps the "TRACE <hex>" lines, prints the events with
+their time and the gap to the previous event, then per event id the count
+and the gaps to the previous event of any kind and of the same kind.
+--bin writes the raw dump (event_trace.h layout) for a host replay build.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x31525445
+HEADER = struct.Struct("<IHHII")
+ENTRY_HEAD = struct.Struct("<II")
+
+DEFAULT_API = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "protocol", "bluetooth", "bt_mesh", "inc", "soc",
+                           "native_gecko.h")
+
+
+def msg_id(header):
+    return header & 0xffff00f8
+
+
+def msg_len(header):
+    return ((header & 0x7) << 8) | ((header & 0xff00) >> 8)
+
+
+def load_names(path):
+    """Event names from the gecko_evt_*_id defines of native_gecko.h"""
+    names = {}
+    if not path or not os.path.exists(path):
+        return names
+    pattern = re.compile(r"#define\s+gecko_evt_(\w+)_id\s+\(\(\(uint32\)"
+                         r"gecko_dev_type_gecko\)\|gecko_msg_type_evt\|"
+                         r"0x([0-9a-fA-F]+)\)")
+    with open(path) as f:
+        for line in f:
+            m = pattern.match(line)
+            if m:
+                names[0x20 | 0x80 | int(m.group(2), 16)] = m.group(1)
+    return names
+
+
+def read_dump(lines):
+    raw = bytearray()
+    for line in lines:
+        m = re.search(r"TRACE ([0-9a-fA-F]+)", line)
+        if m:
+            raw += bytes.fromhex(m.group(1))
+    if len(raw) < HEADER.size:
+        sys.exit("no TRACE lines found")
+    magic, count, entry_size, tick_hz, overwritten = HEADER.unpack_from(raw)
+    if magic != MAGIC:
+        sys.exit("bad trace magic 0x%08x" % magic)
+    if len(raw) < HEADER.size + count * entry_size:
+        sys.exit("dump truncated: %d of %d entries" %
+                 ((len(raw) - HEADER.size) // entry_size, count))
+    entries = []
+    for i in range(count):
+        off = HEADER.size + i * entry_size
+        header, ticks = ENTRY_HEAD.unpack_from(raw, off)
+        data = bytes(raw[off + ENTRY_HEAD.size:off + entry_size])
+        entries.append((header, ticks, data))
+    return bytes(raw[:HEADER.size + count * entry_size]), tick_hz, \
+        overwritten, entries
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("log", nargs="?", help="serial log, stdin if omitted")
+    ap.add_argument("--api", default=DEFAULT_API,
+                    help="native_gecko.h used to name the events")
+    ap.add_argument("--bin", help="write the binary dump here")
+    ap.add_argument("--summary", action="store_true",
+                    help="only print the per event statistics")
+    args = ap.parse_args()
+
+    src = open(args.log) if args.log else sys.stdin
+    raw, tick_hz, overwritten, entries = read_dump(src)
+    names = load_names(args.api)
+
+    if args.bin:
+        with open(args.bin, "wb") as f:
+            f.write(raw)
+
+    print("%d events, %d overwritten before the first" %
+          (len(entries), overwritten))
+    stats = {}
+    last_by_id = {}
+    prev = None
+    for i, (header, ticks, data) in enumerate(entries):
+        eid = msg_id(header)
+        name = names.get(eid, "0x%08x" % eid)
+        # RTCC ticks wrap at 32 bits, gaps are taken modulo 2^32
+        gap = (ticks - prev) % (1 << 32) * 1000.0 / tick_hz \
+            if prev is not None else None
+        same = (ticks - last_by_id[eid]) % (1 << 32) * 1000.0 / tick_hz \
+            if eid in last_by_id else None
+        prev = ticks
+        last_by_id[eid] = ticks
+
+        s = stats.setdefault(name, {"count": 0, "gaps": [], "periods": []})
+        s["count"] += 1
+        if gap is not None:
+            s["gaps"].append(gap)
+        if same is not None:
+            s["periods"].append(same)
+
+        if not args.summary:
+            keep = min(msg_len(header), len(data))
+            print("%4d %12.3f %+10.3f %-45s len %3d %s" %
+                  (i, ticks * 1000.0 / tick_hz, gap or 0.0, name,
+                   msg_len(header), data[:keep].hex()))
+
+    print()
+    print("%-45s %6s %29s %29s" % ("event", "count",
+                                   "gap ms min/avg/max",
+                                   "period ms min/avg/max"))
+
+    def mam(v):
+        if not v:
+            return "-"
+        return "%.1f/%.1f/%.1f" % (min(v), sum(v) / len(v), max(v))
+
+    for name, s in sorted(stats.items(), key=lambda kv: -kv[1]["count"]):
+        print("%-45s %6d %29s %29s" % (name, s["count"], mam(s["gaps"]),
+                                       mam(s["periods"])))
+
+
+if __name__ == "__main__":
+    main()
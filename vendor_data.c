@@ -0,0 +1,370 @@
+/***************************************************************************//**
+ * @file
+ * @brief vendor_data.c
+ * Messages are serialized straight into the BGAPI command buffer, where
+ * gecko_cmd_mesh_vendor_model_send() would copy them from a second buffer.
+ * Everything a message needs is therefore gathered first: no other gecko_cmd
+ * may run between vendor_payload() and vendor_send().
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lpn_table.h"
+#include "receive_node.h"
+#include "report_sched.h"
+#include "report_auth.h"
+#include "send_queue.h"
+#include "env_sensor.h"
+#include "node_store.h"
+#include "node_hb.h"
+#include "time_sync.h"
+#include "app_time.h"
+#include "event_dispatch.h"
+#include "vendor_data.h"
+
+static const uint8 vendor_opcodes[] = { VENDOR_OP_TELEMETRY,
+		VENDOR_OP_CONFIG_SET, VENDOR_OP_CONFIG_STATUS, VENDOR_OP_QUERY,
+		VENDOR_OP_QUERY_STATUS, VENDOR_OP_ALARM_SUMMARY, VENDOR_OP_TIME_REQUEST,
+		VENDOR_OP_TIME_STATUS, VENDOR_OP_TELEMETRY_TS, };
+
+static vendor_data_stats_t stats;
+static uint16 vendor_elem_index;
+static bool vendor_started;
+static uint8 telemetry_seq;
+
+static void vendor_data_on_event(struct gecko_cmd_packet *evt) {
+	vendor_data_on_receive(&evt->data.evt_mesh_vendor_model_receive);
+}
+
+void vendor_data_init(void) {
+	memset(&stats, 0, sizeof(stats));
+	vendor_started = false;
+	telemetry_seq = 0;
+	event_dispatch_register(gecko_evt_mesh_vendor_model_receive_id,
+			vendor_data_on_event);
+}
+
+void vendor_data_start(uint16 elem_index) {
+	uint16 result;
+
+	vendor_elem_index = elem_index;
+	result = gecko_cmd_mesh_vendor_model_init(elem_index,
+	VENDOR_DATA_COMPANY_ID, VENDOR_DATA_MODEL_ID, 0, sizeof(vendor_opcodes),
+			vendor_opcodes)->result;
+	if (result) {
+		printf("Vendor model init failed 0x%x !!!\r\n", result);
+		return;
+	}
+	vendor_started = true;
+}
+
+bool vendor_data_gateway_ready(void) {
+	return vendor_started && stats.gateway_seen;
+}
+
+static uint8 *vendor_payload(void) {
+	struct gecko_cmd_packet *cmd = (struct gecko_cmd_packet *) gecko_cmd_msg_buf;
+
+	return cmd->data.cmd_mesh_vendor_model_send.payload.data;
+}
+
+/* Same as gecko_cmd_mesh_vendor_model_send() less the payload copy */
+static uint16 vendor_send(uint16 dst, uint16 appkey_index, uint8 opcode,
+		uint8 len) {
+	struct gecko_cmd_packet *cmd = (struct gecko_cmd_packet *) gecko_cmd_msg_buf;
+	struct gecko_cmd_packet *rsp = (struct gecko_cmd_packet *) gecko_rsp_msg_buf;
+	uint16 result;
+
+	cmd->data.cmd_mesh_vendor_model_send.elem_index = vendor_elem_index;
+	cmd->data.cmd_mesh_vendor_model_send.vendor_id = VENDOR_DATA_COMPANY_ID;
+	cmd->data.cmd_mesh_vendor_model_send.model_id = VENDOR_DATA_MODEL_ID;
+	cmd->data.cmd_mesh_vendor_model_send.destination_address = dst;
+	cmd->data.cmd_mesh_vendor_model_send.va_index = 0;
+	cmd->data.cmd_mesh_vendor_model_send.appkey_index = appkey_index;
+	cmd->data.cmd_mesh_vendor_model_send.nonrelayed = 0;
+	cmd->data.cmd_mesh_vendor_model_send.opcode = opcode;
+	cmd->data.cmd_mesh_vendor_model_send.final = 1;
+	cmd->data.cmd_mesh_vendor_model_send.payload.len = len;
+	cmd->header = gecko_cmd_mesh_vendor_model_send_id + ((15 + len) << 8);
+	sli_bt_cmd_handler_delegate(cmd->header, sli_bt_cmd_mesh_vendor_model_send,
+			&cmd->data.payload);
+
+	result = rsp->data.rsp_mesh_vendor_model_send.result;
+	if (result) {
+		printf("Vendor send 0x%x failed 0x%x !!!\r\n", opcode, result);
+		stats.send_failures++;
+	}
+	return result;
+}
+
+static uint8 put_le16(uint8 *p, uint16 value) {
+	p[0] = value & 0xff;
+	p[1] = value >> 8;
+	return 2;
+}
+
+static uint8 put_le32(uint8 *p, uint32 value) {
+	put_le16(p, value & 0xffff);
+	put_le16(&p[2], value >> 16);
+	return 4;
+}
+
+static uint32 get_le32(const uint8 *p) {
+	return p[0] | (p[1] << 8) | ((uint32) p[2] << 16) | ((uint32) p[3] << 24);
+}
+
+static uint16 age_units(uint32 now, uint32 stamp_ms) {
+	uint32 age = (now - stamp_ms) / VENDOR_DATA_AGE_UNIT_MS;
+
+	return age > 0xffff ? 0xffff : age;
+}
+
+bool vendor_data_send_report(uint16 dst, uint16 src, uint16 node_record) {
+	uint16 trailer[REPORT_AUTH_TRAILER_LEN];
+	uint8 trailer_len;
+	uint16 count = 1 + lpn_table.count;
+	uint32 now = app_time_ms();
+	uint8 len = 0;
+	uint8 *p;
+	uint16 i;
+
+	if (!vendor_started || count > VENDOR_DATA_MAX_STAMPED) {
+		return false;
+	}
+
+	report_auth_begin(src);
+	report_auth_add(node_record);
+	for (i = 0; i < lpn_table.count; i++) {
+		report_auth_add(lpn_table_message(i));
+	}
+	//Sealing may save the frame counter to PS, so it precedes serialization
+	trailer_len = report_auth_seal(trailer);
+
+	p = vendor_payload();
+	p[len++] = telemetry_seq;
+	p[len++] = time_sync_is_synced();
+	len += put_le32(&p[len], time_sync_to_gateway(now));
+	p[len++] = count;
+	len += put_le16(&p[len], node_record);
+	len += put_le16(&p[len], 0);
+	for (i = 0; i < lpn_table.count; i++) {
+		len += put_le16(&p[len], lpn_table_message(i));
+		len += put_le16(&p[len], age_units(now, lpn_table.stamp_ms[i]));
+	}
+	//The trailer runs to the end of the payload
+	for (i = 0; i < trailer_len; i++) {
+		len += put_le16(&p[len], trailer[i]);
+	}
+	if (vendor_send(dst, APP_KEY_INDEX, VENDOR_OP_TELEMETRY_TS, len)) {
+		return false;
+	}
+	telemetry_seq++;
+	stats.telemetry_sent++;
+	return true;
+}
+
+bool vendor_data_send_alarm_summary(uint16 dst, const alarm_summary_t *summary) {
+	uint8 len = 0;
+	uint8 *p;
+
+	if (!vendor_started) {
+		return false;
+	}
+	p = vendor_payload();
+	len += put_le16(&p[len], summary->source);
+	len += put_le16(&p[len], summary->repeats);
+	len += put_le32(&p[len], time_sync_to_gateway(summary->first_ms));
+	len += put_le32(&p[len], time_sync_to_gateway(summary->last_ms));
+	len += put_le16(&p[len], summary->message);
+	p[len++] = time_sync_is_synced();
+	return vendor_send(dst, APP_KEY_INDEX, VENDOR_OP_ALARM_SUMMARY, len) == 0;
+}
+
+bool vendor_data_send_time_request(uint16 dst, uint8 seq, uint32 local_ms) {
+	uint8 len = 0;
+	uint8 *p;
+
+	if (!vendor_started) {
+		return false;
+	}
+	p = vendor_payload();
+	p[len++] = seq;
+	len += put_le32(&p[len], local_ms);
+	return vendor_send(dst, APP_KEY_INDEX, VENDOR_OP_TIME_REQUEST, len) == 0;
+}
+
+static bool vendor_config_apply(const uint8 *data, uint8 len) {
+	report_sched_state_t sched;
+	node_hb_state_t hb;
+	uint8 pos = 0;
+
+	while (pos + 2 <= len) {
+		uint8 id = data[pos];
+		uint8 vlen = data[pos + 1];
+		const uint8 *v = &data[pos + 2];
+		uint16 value;
+
+		if (vlen == 0 || vlen > 2 || pos + 2 + vlen > len) {
+			return false;
+		}
+		value = vlen == 2 ? (v[0] | (v[1] << 8)) : v[0];
+		report_sched_get_state(&sched);
+		node_hb_get_state(&hb);
+		switch (id) {
+		case VENDOR_CFG_REPORT_INTERVAL:
+			report_sched_set_enabled(false);
+			receive_node_set_report_interval(value);
+			break;
+		case VENDOR_CFG_REPORT_MIN:
+			report_sched_set_bounds(value, sched.max_s);
+			break;
+		case VENDOR_CFG_REPORT_MAX:
+			report_sched_set_bounds(sched.min_s, value);
+			break;
+		case VENDOR_CFG_SCHED_ENABLE:
+			report_sched_set_enabled(value != 0);
+			break;
+		case VENDOR_CFG_SENSOR_CADENCE:
+			env_sensor_set_cadence(value);
+			break;
+		case VENDOR_CFG_ALARM_WINDOW:
+			alarm_coalesce_set_window(value);
+			break;
+		case VENDOR_CFG_HB_PERIOD_LOG:
+			node_hb_configure(value, hb.ttl);
+			break;
+		case VENDOR_CFG_HB_TTL:
+			node_hb_configure(hb.period_log, value);
+			break;
+		case VENDOR_CFG_SYNC_INTERVAL:
+			time_sync_set_interval(value);
+			break;
+		default:
+			//Settings of newer gateways are skipped
+			break;
+		}
+		pos += 2 + vlen;
+	}
+	node_store_mark_dirty();
+	return pos == len;
+}
+
+static uint8 put_setting(uint8 *p, uint8 id, uint16 value) {
+	p[0] = id;
+	p[1] = 2;
+	return 2 + put_le16(&p[2], value);
+}
+
+static void vendor_config_status(uint16 dst, uint16 appkey_index) {
+	uint16 interval = receive_node_get_report_interval();
+	report_sched_state_t sched;
+	env_sensor_state_t env;
+	alarm_coalesce_stats_t alarm;
+	node_hb_state_t hb;
+	time_sync_state_t sync;
+	uint8 len = 0;
+	uint8 *p;
+
+	report_sched_get_state(&sched);
+	env_sensor_get_state(&env);
+	alarm_coalesce_get_stats(&alarm);
+	node_hb_get_state(&hb);
+	time_sync_get_state(&sync);
+
+	p = vendor_payload();
+	len += put_setting(&p[len], VENDOR_CFG_REPORT_INTERVAL, interval);
+	len += put_setting(&p[len], VENDOR_CFG_REPORT_MIN, sched.min_s);
+	len += put_setting(&p[len], VENDOR_CFG_REPORT_MAX, sched.max_s);
+	p[len++] = VENDOR_CFG_SCHED_ENABLE;
+	p[len++] = 1;
+	p[len++] = sched.enabled;
+	len += put_setting(&p[len], VENDOR_CFG_SENSOR_CADENCE, env.cadence_s);
+	len += put_setting(&p[len], VENDOR_CFG_ALARM_WINDOW, alarm.window_ms);
+	p[len++] = VENDOR_CFG_HB_PERIOD_LOG;
+	p[len++] = 1;
+	p[len++] = hb.period_log;
+	p[len++] = VENDOR_CFG_HB_TTL;
+	p[len++] = 1;
+	p[len++] = hb.ttl;
+	len += put_setting(&p[len], VENDOR_CFG_SYNC_INTERVAL, sync.interval_s);
+	vendor_send(dst, appkey_index, VENDOR_OP_CONFIG_STATUS, len);
+}
+
+static void vendor_query(uint16 dst, uint16 appkey_index, uint8 query) {
+	send_queue_stats_t tx;
+	env_sensor_state_t env;
+	uint8 len = 0;
+	uint8 *p;
+	uint16 i;
+
+	send_queue_get_stats(&tx);
+	env_sensor_get_state(&env);
+
+	p = vendor_payload();
+	p[len++] = query;
+	switch (query) {
+	case VENDOR_QUERY_LPN_TABLE:
+		for (i = 0; i < lpn_table.count && len + 3 <= VENDOR_DATA_MAX_PAYLOAD;
+				i++) {
+			len += put_le16(&p[len], lpn_table_message(i));
+			p[len++] = lpn_table.time_out[i];
+		}
+		break;
+	case VENDOR_QUERY_TX_STATS:
+		len += put_le32(&p[len], tx.sent);
+		len += put_le32(&p[len], tx.failed);
+		len += put_le32(&p[len], tx.dropped);
+		len += put_le16(&p[len], tx.pace_ms);
+		break;
+	case VENDOR_QUERY_SENSOR:
+		p[len++] = env.present;
+		p[len++] = (uint8) env.temperature;
+		len += put_le16(&p[len], env.humidity);
+		break;
+	default:
+		//Unknown queries are answered with the id alone
+		break;
+	}
+	vendor_send(dst, appkey_index, VENDOR_OP_QUERY_STATUS, len);
+}
+
+void vendor_data_on_receive(struct gecko_msg_mesh_vendor_model_receive_evt_t *evt) {
+	if (evt->vendor_id != VENDOR_DATA_COMPANY_ID
+			|| evt->model_id != VENDOR_DATA_MODEL_ID) {
+		return;
+	}
+	stats.received++;
+	stats.gateway_seen = true;
+
+	switch (evt->opcode) {
+	case VENDOR_OP_CONFIG_SET:
+		if (!vendor_config_apply(evt->payload.data, evt->payload.len)) {
+			stats.malformed++;
+		}
+		vendor_config_status(evt->source_address, evt->appkey_index);
+		break;
+	case VENDOR_OP_QUERY:
+		if (evt->payload.len < 1) {
+			stats.malformed++;
+			break;
+		}
+		vendor_query(evt->source_address, evt->appkey_index,
+				evt->payload.data[0]);
+		break;
+	case VENDOR_OP_TIME_STATUS:
+		if (evt->payload.len < 9) {
+			stats.malformed++;
+			break;
+		}
+		time_sync_on_status(evt->payload.data[0], get_le32(&evt->payload.data[1]),
+				get_le32(&evt->payload.data[5]));
+		break;
+	default:
+		break;
+	}
+}
+
+void vendor_data_get_stats(vendor_data_stats_t *out) {
+	*out = stats;
+}
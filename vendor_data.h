@@ -0,0 +1,90 @@
+/***************************************************************************//**
+ * @file
+ * @brief vendor_data.h
+ * Vendor model carrying many records per message between node and gateway.
+ ******************************************************************************/
+
+#ifndef VENDOR_DATA_H
+#define VENDOR_DATA_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+#include "alarm_coalesce.h"
+#include "report_auth.h"
+
+#define VENDOR_DATA_COMPANY_ID		0x02ff
+#define VENDOR_DATA_MODEL_ID		0x0001
+
+/* 6 bit vendor opcodes */
+#define VENDOR_OP_TELEMETRY			0x01	/* seq, count, count records, for
+											 * gateways without time sync */
+#define VENDOR_OP_CONFIG_SET		0x02	/* TLV settings */
+#define VENDOR_OP_CONFIG_STATUS		0x03	/* TLV settings in effect */
+#define VENDOR_OP_QUERY				0x04	/* query id */
+#define VENDOR_OP_QUERY_STATUS		0x05	/* query id, query data */
+#define VENDOR_OP_ALARM_SUMMARY		0x06	/* source, repeats, first ms, last ms,
+											 * last alarm record, synced */
+#define VENDOR_OP_TIME_REQUEST		0x07	/* seq, node ms */
+#define VENDOR_OP_TIME_STATUS		0x08	/* seq, echoed node ms, gateway ms */
+#define VENDOR_OP_TELEMETRY_TS		0x09	/* seq, synced, ms, count, count
+											 * records and ages, auth trailer */
+
+/* Settings of CONFIG_SET and CONFIG_STATUS: id, length, little endian value */
+#define VENDOR_CFG_REPORT_INTERVAL	0x01	/* uint16 s, disables adaptation */
+#define VENDOR_CFG_REPORT_MIN		0x02	/* uint16 s */
+#define VENDOR_CFG_REPORT_MAX		0x03	/* uint16 s */
+#define VENDOR_CFG_SCHED_ENABLE		0x04	/* uint8 */
+#define VENDOR_CFG_SENSOR_CADENCE	0x05	/* uint16 s */
+#define VENDOR_CFG_ALARM_WINDOW		0x06	/* uint16 ms, 0 sends every alarm */
+#define VENDOR_CFG_HB_PERIOD_LOG	0x07	/* uint8, heartbeat 2^(n-1) s */
+#define VENDOR_CFG_HB_TTL			0x08	/* uint8 */
+#define VENDOR_CFG_SYNC_INTERVAL	0x09	/* uint16 s */
+
+/* Queries */
+#define VENDOR_QUERY_LPN_TABLE		0x01	/* per LPN: record, time out */
+#define VENDOR_QUERY_TX_STATS		0x02	/* sent, failed, dropped, pace */
+#define VENDOR_QUERY_SENSOR			0x03	/* temperature, humidity */
+
+/* Segments of 12 bytes in one message. A segmented access message takes up
+ * to 32, fewer keep the lengths here in a byte and the airtime of a message
+ * short. Not to be confused with MESH_CFG_MAX_SEND_SEGS, which counts the
+ * segmented messages the stack has in flight. */
+#define VENDOR_DATA_MAX_SEGS		8
+#if VENDOR_DATA_MAX_SEGS > 32
+#error "A segmented access message has at most 32 segments"
+#endif
+/* Access payload of VENDOR_DATA_MAX_SEGS segments, less the 4 byte TransMIC
+ * and the 3 byte vendor opcode */
+#define VENDOR_DATA_MAX_PAYLOAD		(VENDOR_DATA_MAX_SEGS * 12 - 4 - 3)
+/* Records of one telemetry message */
+#define VENDOR_DATA_MAX_RECORDS		((VENDOR_DATA_MAX_PAYLOAD - 2) / 2)
+/* Stamped records of one telemetry message next to the auth trailer */
+#define VENDOR_DATA_MAX_STAMPED		((VENDOR_DATA_MAX_PAYLOAD - 7 \
+		- 2 * REPORT_AUTH_TRAILER_LEN) / 4)
+/* Record ages are sent in 100 ms units, saturated */
+#define VENDOR_DATA_AGE_UNIT_MS		100
+
+typedef struct {
+	bool gateway_seen;	/* the gateway talked vendor model to us */
+	uint32 telemetry_sent;
+	uint32 send_failures;
+	uint32 received;
+	uint32 malformed;
+} vendor_data_stats_t;
+
+void vendor_data_init(void);
+/* Register the model on the element once the node is provisioned */
+void vendor_data_start(uint16 elem_index);
+bool vendor_data_gateway_ready(void);
+/* The node record and the LPN table in one message, each record with the age
+ * of its last update, with the report_auth trailer when authentication is
+ * on. False if it could not be sent. */
+bool vendor_data_send_report(uint16 dst, uint16 src, uint16 node_record);
+/* Times of the summary in app_time_ms(), sent in gateway time once synced */
+bool vendor_data_send_alarm_summary(uint16 dst, const alarm_summary_t *summary);
+bool vendor_data_send_time_request(uint16 dst, uint8 seq, uint32 local_ms);
+void vendor_data_on_receive(struct gecko_msg_mesh_vendor_model_receive_evt_t *evt);
+void vendor_data_get_stats(vendor_data_stats_t *stats);
+
+#endif /* VENDOR_DATA_H */
@@ -0,0 +1,108 @@
+/***************************************************************************//**
+ * @file
+ * @brief work_queue.c
+ * Run to completion: an item runs once and is not preempted by other work.
+ * Each priority is a ring so items of one priority keep their order.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "work_queue.h"
+
+typedef struct {
+	work_fn fn;
+	uint32 arg;
+} work_item_t;
+
+typedef struct {
+	work_item_t item[WORK_QUEUE_DEPTH];
+	uint8 head;
+	uint8 count;
+} work_ring_t;
+
+static work_ring_t rings[WORK_PRIO_NUM];
+static work_queue_stats_t stats;
+static uint8 total;
+
+void work_queue_init(void) {
+	memset(rings, 0, sizeof(rings));
+	memset(&stats, 0, sizeof(stats));
+	total = 0;
+}
+
+bool work_queue_post(uint8 prio, work_fn fn, uint32 arg) {
+	work_ring_t *ring;
+	uint8 i;
+
+	if (prio >= WORK_PRIO_NUM) {
+		return false;
+	}
+	ring = &rings[prio];
+	for (i = 0; i < ring->count; i++) {
+		work_item_t *w = &ring->item[(ring->head + i) & (WORK_QUEUE_DEPTH - 1)];
+
+		if (w->fn == fn && w->arg == arg) {
+			stats.coalesced++;
+			return true;
+		}
+	}
+	if (ring->count == WORK_QUEUE_DEPTH) {
+		stats.dropped++;
+		return false;
+	}
+	ring->item[(ring->head + ring->count) & (WORK_QUEUE_DEPTH - 1)] =
+			(work_item_t ) { fn, arg };
+	ring->count++;
+	stats.posted++;
+	if (++total > stats.max_depth) {
+		stats.max_depth = total;
+	}
+	return true;
+}
+
+bool work_queue_pending(void) {
+	return total != 0;
+}
+
+static bool work_take(work_item_t *out) {
+	uint8 p;
+
+	for (p = 0; p < WORK_PRIO_NUM; p++) {
+		work_ring_t *ring = &rings[p];
+
+		if (ring->count) {
+			*out = ring->item[ring->head];
+			ring->head = (ring->head + 1) & (WORK_QUEUE_DEPTH - 1);
+			ring->count--;
+			total--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void work_queue_run(uint32 budget_ticks) {
+	uint64_t start = app_time_ticks();
+	uint64_t now = start;
+	work_item_t w;
+
+	stats.drains++;
+	while (now - start < budget_ticks && work_take(&w)) {
+		uint64_t item_start = now;
+
+		//May post more work, it runs in this drain if the budget allows
+		w.fn(w.arg);
+		stats.run++;
+		now = app_time_ticks();
+		if (now - item_start > stats.max_item_ticks) {
+			stats.max_item_ticks = now - item_start;
+		}
+	}
+	if (total) {
+		stats.over_budget++;
+	}
+}
+
+void work_queue_get_stats(work_queue_stats_t *out) {
+	*out = stats;
+}
@@ -0,0 +1,52 @@
+/***************************************************************************//**
+ * @file
+ * @brief work_queue.h
+ * Deferred work posted by event handlers, run from the main loop when no
+ * stack event is waiting.
+ ******************************************************************************/
+
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <stdbool.h>
+#include "bg_types.h"
+
+#include "app_time.h"
+
+/* Items per priority, a power of 2 */
+#define WORK_QUEUE_DEPTH		8
+/* Time one drain may take before the loop goes back to the stack. An item
+ * is never cut short, so the worst case adds the longest item. */
+#define WORK_QUEUE_BUDGET_MS	5
+#define WORK_QUEUE_BUDGET_TICKS	\
+	((WORK_QUEUE_BUDGET_MS * APP_TIME_TICKS_PER_SEC) / 1000)
+
+typedef enum {
+	WORK_PRIO_HIGH,
+	WORK_PRIO_NORMAL,
+	WORK_PRIO_LOW,
+	WORK_PRIO_NUM,
+} work_prio_t;
+
+typedef void (*work_fn)(uint32 arg);
+
+typedef struct {
+	uint32 posted;
+	uint32 coalesced;	/* posts of an item already pending */
+	uint32 dropped;		/* priority full */
+	uint32 run;
+	uint32 drains;
+	uint32 over_budget;	/* drains that stopped with work left */
+	uint32 max_item_ticks;
+	uint8 max_depth;
+} work_queue_stats_t;
+
+void work_queue_init(void);
+/* The same function and argument pending already is not queued twice */
+bool work_queue_post(uint8 prio, work_fn fn, uint32 arg);
+bool work_queue_pending(void);
+/* Highest priority first, until empty or the budget is spent */
+void work_queue_run(uint32 budget_ticks);
+void work_queue_get_stats(work_queue_stats_t *stats);
+
+#endif /* WORK_QUEUE_H */